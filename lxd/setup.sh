@@ -123,6 +123,9 @@ Restart=on-failure
 RestartSec=10
 WorkingDirectory=/home/ubuntu
 ExecStart=/home/ubuntu/run.sh
+# reload upgrades to a new apiserver binary without dropping connections
+ExecReload=/bin/kill -USR2 $MAINPID
+NotifyAccess=all
 SyslogIdentifier=apiserver
 
 [Install]
@@ -162,7 +165,7 @@ export REMOTE_API_USER="mcordova"
 export REMOTE_API_PASS="basica"
 
 # executable
-./apiserver
+exec ./apiserver
 EOF
 
 sudo chmod +x run.sh
@@ -0,0 +1,107 @@
+#ifndef AGENT_CHECK_HPP
+#define AGENT_CHECK_HPP
+
+#include "metrics.hpp"
+#include "logger.hpp"
+#include "util.hpp"
+
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <format>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+class agent_check_error : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+/**
+ * @brief TCP responder for HAProxy's agent-check.
+ *
+ * HAProxy connects to AGENT_CHECK_PORT every inter interval and reads one line: "ready up 73%" sets the
+ * server's weight to 73% of its configured weight, "drain" stops new traffic without failing the server.
+ * The line comes from metrics::load(), so a saturated instance gets fewer connections before it starts
+ * rejecting requests. Runs on its own thread: checks arrive a few times per second, not per request.
+ */
+class agent_check {
+public:
+    agent_check(uint16_t port, std::shared_ptr<const metrics> metrics_ptr) : m_metrics(std::move(metrics_ptr)) {
+        m_fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (m_fd == -1) throw agent_check_error("Failed to create the agent-check socket");
+        // A server being upgraded still answers on the port while its successor binds it
+        int opt = 1;
+        setsockopt(m_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+        setsockopt(m_fd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt));
+
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = INADDR_ANY;
+        addr.sin_port = htons(port);
+        if (bind(m_fd, (sockaddr*)&addr, sizeof(addr)) == -1 || listen(m_fd, BACKLOG) == -1) { // NOSONAR: C sockets API
+            close(m_fd);
+            throw agent_check_error(std::format("Agent-check bind failed on port {}: {}", port, util::str_error_cpp(errno)));
+        }
+        m_thread = std::jthread([this](std::stop_token stop) { run(stop); });
+    }
+
+    ~agent_check() noexcept {
+        m_thread.request_stop();
+        if (m_thread.joinable()) m_thread.join();
+        close(m_fd);
+    }
+
+    agent_check(const agent_check&) = delete;
+    agent_check& operator=(const agent_check&) = delete;
+    agent_check(agent_check&&) = delete;
+    agent_check& operator=(agent_check&&) = delete;
+
+    // The agent protocol line for a load report
+    [[nodiscard]] static std::string reply(const metrics::load_report& load) {
+        return load.drain ? std::string("drain\n") : std::format("ready up {}%\n", load.weight);
+    }
+
+private:
+    static constexpr int BACKLOG{64};
+    static constexpr int POLL_TIMEOUT_MS{250}; // how long a stop request may wait
+
+    void run(const std::stop_token& stop) const {
+        pollfd pfd{m_fd, POLLIN, 0};
+        while (!stop.stop_requested()) {
+            if (poll(&pfd, 1, POLL_TIMEOUT_MS) <= 0) continue;
+            while (true) {
+                const int client = accept4(m_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                if (client == -1) break;
+                answer(client);
+            }
+        }
+    }
+
+    // Writes the line and hangs up; the reply fits in the socket buffer, so it never blocks
+    void answer(int client) const {
+        const std::string line = reply(m_metrics->load());
+        if (send(client, line.data(), line.size(), MSG_NOSIGNAL | MSG_DONTWAIT) == -1) {
+            util::log::debug("Agent-check reply failed: {}", util::str_error_cpp(errno));
+        }
+        // Anything HAProxy sent (agent-send) is discarded, so closing does not reset the connection
+        std::array<char, 256> discard;
+        while (recv(client, discard.data(), discard.size(), MSG_DONTWAIT) > 0) {
+            // keep reading until the socket is empty
+        }
+        shutdown(client, SHUT_WR);
+        close(client);
+    }
+
+    std::shared_ptr<const metrics> m_metrics;
+    int m_fd{-1};
+    std::jthread m_thread;
+};
+
+#endif // AGENT_CHECK_HPP
@@ -5,17 +5,59 @@
 #include "http_response.hpp"
 #include "input_validator.hpp"
 #include "webapi_path.hpp"
+#include "concurrency_limiter.hpp"
+#include "handler_usage.hpp"
+#include "thread_pool.hpp"
+#include "task.hpp"
+#include <algorithm>
+#include <chrono>
+#include <concepts>
+#include <optional>
+#include <string>
 #include <string_view>
 #include <unordered_map>
 #include <functional>
 #include <memory>
+#include <utility>
+#include <vector>
 
 // A type alias for our API handler functions
 using api_handler_func = std::function<void(const http::request&, http::response&)>;
 
+// A coroutine handler: it gives its worker thread back while it waits (see task.hpp)
+using async_handler_func = std::function<async::task<void>(const http::request&, http::response&)>;
+
+// Anything register_api() accepts as a handler, plain or coroutine
+template<typename F>
+concept api_handler = std::invocable<F&, const http::request&, http::response&>;
+
+template<typename F>
+concept coroutine_handler = api_handler<F>
+    && std::same_as<std::invoke_result_t<F&, const http::request&, http::response&>, async::task<void>>;
+
 // A type-erased wrapper for our validation logic
 using validator_func = std::function<void(const http::request&)>;
 
+/**
+ * @brief Where an endpoint's handler runs.
+ * @details worker_pool hands the request to the thread pool; io_thread runs the handler inline on the
+ * I/O thread that parsed it and writes the response immediately. Use io_thread only for handlers that
+ * never block (no SQL, remote calls or disk I/O): while one runs, its reactor serves no other connection.
+ */
+enum class execution { worker_pool, io_thread };
+
+/**
+ * @brief The worker pool an endpoint runs on, its priority there and its time budget.
+ * @details Named pools are bulkheads: each has its own threads and queues, so a burst on one endpoint
+ * (password hashing, long reports) cannot take the workers of the others. An empty name is the
+ * default pool sized by POOL_SIZE. Pools are declared with server::add_worker_pool().
+ */
+struct worker_lane {
+    std::string_view pool{};
+    thread_pool::priority prio{thread_pool::priority::normal};
+    std::chrono::milliseconds timeout{0}; // request budget; 0 uses REQUEST_TIMEOUT_SECONDS
+};
+
 /**
  * @struct api_endpoint
  * @brief Holds all the information for a registered API endpoint.
@@ -25,6 +67,15 @@ struct api_endpoint {
     validator_func validator;
     api_handler_func handler;
     bool is_secure;
+    execution mode{execution::worker_pool};
+    std::shared_ptr<concurrency_limiter> limiter; // null when requests are not limited
+    std::string pool{};                 // empty for the default pool
+    thread_pool::priority prio{thread_pool::priority::normal};
+    std::chrono::milliseconds timeout{0}; // 0 uses the server's default budget
+    size_t pool_index{0};               // set by resolve_pools(); 0 is the default pool
+    async_handler_func async_handler{}; // set instead of handler for coroutine handlers
+    std::shared_ptr<handler_usage::endpoint_usage> usage{}; // null when CPU time is not accounted
+    std::string_view path_param{};      // name of the last path segment, for routes like /download/{name}
 };
 
 /**
@@ -39,26 +90,107 @@ public:
      * @param path The compile-time validated URI path.
      * @param method The required HTTP method for this endpoint.
      * @param v The validator instance for this endpoint.
-     * @param handler The function to execute for this endpoint.
+     * @param handler The function to execute for this endpoint, or a coroutine returning async::task<void>.
      * @param is_secure True if the endpoint requires authentication.
+     * @param mode Whether the handler runs on the worker pool or inline on the I/O thread.
+     */
+    template<typename Validator, api_handler Handler>
+    void register_api(webapi_path path, http::method method, const Validator& v, Handler&& handler, bool is_secure = true,
+                      execution mode = execution::worker_pool) {
+        validator_func vf = [v](const http::request& req) {
+            v.validate(req);
+        };
+        set_handler(add_route(path, {method, std::move(vf), {}, is_secure, mode, nullptr}), std::forward<Handler>(handler));
+    }
+
+    /**
+     * @brief Registers an API endpoint that runs on a given worker pool and priority.
+     * @param lane The pool, by name, and the priority of this endpoint's requests in it.
      */
-    template<typename Validator>
-    void register_api(webapi_path path, http::method method, const Validator& v, api_handler_func handler, bool is_secure = true) {
+    template<typename Validator, api_handler Handler>
+    void register_api(webapi_path path, http::method method, const Validator& v, Handler&& handler, bool is_secure,
+                      worker_lane lane) {
         validator_func vf = [v](const http::request& req) {
             v.validate(req);
         };
-        m_routes[path.get()] = {method, std::move(vf), std::move(handler), is_secure};
+        set_handler(add_route(path, {method, std::move(vf), {}, is_secure, execution::worker_pool, nullptr,
+                                            std::string(lane.pool), lane.prio, lane.timeout}),
+                    std::forward<Handler>(handler));
     }
 
     /**
      * @brief Registers an API endpoint that has no validation rules.
      */
-    void register_api(webapi_path path, http::method method, api_handler_func handler, bool is_secure = true) {
+    template<api_handler Handler>
+    void register_api(webapi_path path, http::method method, Handler&& handler, bool is_secure = true,
+                      execution mode = execution::worker_pool) {
         // Create a no-op validator for endpoints that do not require input validation.
         validator_func vf = [](const http::request&){
             // This lambda is intentionally empty as no validation is needed for this endpoint type.
         };
-        m_routes[path.get()] = {method, std::move(vf), std::move(handler), is_secure};
+        set_handler(add_route(path, {method, std::move(vf), {}, is_secure, mode, nullptr}), std::forward<Handler>(handler));
+    }
+
+    /**
+     * @brief Registers an API endpoint without validation rules that runs on a given worker pool and priority.
+     */
+    template<api_handler Handler>
+    void register_api(webapi_path path, http::method method, Handler&& handler, bool is_secure, worker_lane lane) {
+        validator_func vf = [](const http::request&){
+            // This lambda is intentionally empty as no validation is needed for this endpoint type.
+        };
+        set_handler(add_route(path, {method, std::move(vf), {}, is_secure, execution::worker_pool, nullptr,
+                                            std::string(lane.pool), lane.prio, lane.timeout}),
+                    std::forward<Handler>(handler));
+    }
+
+    /**
+     * @brief Maps the pool name of every endpoint to the index of that pool.
+     * @details Must be called before the server starts.
+     * @param names The named pools; the pool at names[i] gets index i + 1, the default pool is 0.
+     * @return The first pool name that was never declared, if any.
+     */
+    std::optional<std::string> resolve_pools(const std::vector<std::string>& names) {
+        for (auto& [path, endpoint] : m_routes) {
+            if (endpoint.pool.empty()) continue;
+            const auto it = std::ranges::find(names, endpoint.pool);
+            if (it == names.end()) return endpoint.pool;
+            endpoint.pool_index = static_cast<size_t>(it - names.begin()) + 1;
+        }
+        return std::nullopt;
+    }
+
+    /**
+     * @brief Gives every worker_pool endpoint its own adaptive concurrency limiter.
+     * @details Must be called before the server starts. Inline endpoints never queue and stay unlimited.
+     * @return The path and limiter of each limited endpoint, for metrics registration.
+     */
+    std::vector<std::pair<std::string_view, std::shared_ptr<const concurrency_limiter>>>
+    enable_concurrency_limits(const concurrency_limiter::options& opts) {
+        std::vector<std::pair<std::string_view, std::shared_ptr<const concurrency_limiter>>> limiters;
+        for (auto& [path, endpoint] : m_routes) {
+            if (endpoint.mode != execution::worker_pool) continue;
+            endpoint.limiter = std::make_shared<concurrency_limiter>(opts);
+            limiters.emplace_back(path, endpoint.limiter);
+        }
+        return limiters;
+    }
+
+    /**
+     * @brief Gives every endpoint with a plain handler its CPU-time and context-switch totals.
+     * @details Must be called before the server starts. Coroutine handlers are left out: they move between
+     * threads, so one thread's CPU clock does not measure them.
+     * @return The path and totals of each accounted endpoint, for metrics registration.
+     */
+    std::vector<std::pair<std::string_view, std::shared_ptr<const handler_usage::endpoint_usage>>>
+    enable_usage_accounting() {
+        std::vector<std::pair<std::string_view, std::shared_ptr<const handler_usage::endpoint_usage>>> totals;
+        for (auto& [path, endpoint] : m_routes) {
+            if (endpoint.async_handler) continue;
+            endpoint.usage = std::make_shared<handler_usage::endpoint_usage>();
+            totals.emplace_back(path, endpoint.usage);
+        }
+        return totals;
     }
 
     /**
@@ -68,12 +200,39 @@ public:
      */
     [[nodiscard]] const api_endpoint* find_handler(std::string_view path) const {
         if (auto it = m_routes.find(path); it != m_routes.end()) {
-            return &it->second;
+            // "/download/" itself lacks the segment its parameter needs
+            return it->second.path_param.empty() ? &it->second : nullptr;
+        }
+        // Otherwise a route whose last segment is a parameter, keyed by everything up to that segment
+        if (const auto slash = path.rfind('/'); slash != std::string_view::npos && slash + 1 < path.size()) {
+            if (auto it = m_routes.find(path.substr(0, slash + 1)); it != m_routes.end()) {
+                return &it->second;
+            }
         }
         return nullptr;
     }
 
+    // True if any endpoint is a coroutine, so the server knows the blocking pool will be used
+    [[nodiscard]] bool has_coroutine_handlers() const {
+        return std::ranges::any_of(m_routes, [](const auto& route) { return static_cast<bool>(route.second.async_handler); });
+    }
+
 private:
+    api_endpoint& add_route(webapi_path path, api_endpoint&& endpoint) {
+        endpoint.path_param = path.param();
+        return m_routes[path.route()] = std::move(endpoint);
+    }
+
+    template<api_handler Handler>
+    static void set_handler(api_endpoint& endpoint, Handler&& handler) {
+        if constexpr (coroutine_handler<std::remove_cvref_t<Handler>>) {
+            endpoint.async_handler = std::forward<Handler>(handler);
+            endpoint.mode = execution::worker_pool; // it starts on a worker; the I/O thread must never run one
+        } else {
+            endpoint.handler = std::forward<Handler>(handler);
+        }
+    }
+
     // NOTE: The key is string_view, which is efficient but assumes the lifetime
     // of the path string is managed externally (which is true for webapi_path).
     std::unordered_map<std::string_view, api_endpoint> m_routes;
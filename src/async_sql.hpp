@@ -0,0 +1,138 @@
+#ifndef ASYNC_SQL_HPP
+#define ASYNC_SQL_HPP
+
+#include "task.hpp"
+#include "thread_pool.hpp"
+#include "sql.hpp"
+#include "env.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+/**
+ * @brief Awaitables that run blocking calls, ODBC above all, on a dedicated pool.
+ *
+ * ODBC has no asynchronous interface the drivers agree on, so a coroutine handler hands the call to the
+ * blocking pool and gives its worker back while the statement runs. Each blocking thread keeps its own
+ * ODBC connections, like the workers do.
+ */
+namespace async {
+
+/**
+ * @brief The process-wide pool for blocking calls made by coroutine handlers.
+ * @details Started on first use with BLOCKING_POOL_SIZE threads (default 16). Its size bounds how many
+ * statements run at once; BLOCKING_QUEUE_CAPACITY (default 1024) bounds how many calls wait for a thread.
+ */
+inline thread_pool& blocking_pool() {
+    struct started_pool {
+        thread_pool pool;
+        // Blocking calls are all pushed at normal priority, whose ring holds a third of the pool's capacity
+        started_pool(size_t threads, size_t waiting) : pool(threads, std::max<size_t>(waiting, 1) * thread_pool::PRIORITY_LEVELS, "blocking") {
+            pool.start();
+        }
+    };
+    static started_pool instance(env::get<size_t>("BLOCKING_POOL_SIZE", 16uz), env::get<size_t>("BLOCKING_QUEUE_CAPACITY", 1024uz));
+    return instance.pool;
+}
+
+/**
+ * @class blocking_awaiter
+ * @brief Runs a callable on the blocking pool and resumes the coroutine there with its result.
+ */
+template<typename F>
+class blocking_awaiter {
+public:
+    using result_type = std::invoke_result_t<F&>;
+
+    explicit blocking_awaiter(F fn) : m_fn(std::move(fn)) {}
+
+    [[nodiscard]] bool await_ready() const noexcept { return false; }
+
+    // Throws queue_full_error into the coroutine if the pool cannot take the call
+    void await_suspend(std::coroutine_handle<> handle) {
+        blocking_pool().push_task([this, handle] {
+            const resume_context context = m_context; // this awaiter may be gone once the coroutine moves on
+            context.apply([this] { run(); });
+            context.resume(handle);
+        });
+    }
+
+    result_type await_resume() {
+        if (m_error) std::rethrow_exception(m_error);
+        if constexpr (!std::is_void_v<result_type>) {
+            return std::move(*m_result);
+        }
+    }
+
+private:
+    // Under the handler's deadline, so ODBC query timeouts still apply
+    void run() noexcept {
+        try {
+            if constexpr (std::is_void_v<result_type>) {
+                m_fn();
+            } else {
+                m_result.emplace(m_fn());
+            }
+        } catch (...) {
+            m_error = std::current_exception();
+        }
+    }
+
+    F m_fn;
+    resume_context m_context{resume_context::capture()}; // taken where the handler awaits
+    std::conditional_t<std::is_void_v<result_type>, std::monostate, std::optional<result_type>> m_result;
+    std::exception_ptr m_error;
+};
+
+/**
+ * @brief co_await run_blocking(fn) runs fn on the blocking pool and yields what it returns.
+ * @details The handler resumes on the blocking thread; heavy work after the await can run there.
+ */
+template<typename F>
+[[nodiscard]] blocking_awaiter<std::decay_t<F>> run_blocking(F&& fn) {
+    return blocking_awaiter<std::decay_t<F>>(std::forward<F>(fn));
+}
+
+// Awaitable versions of the sql:: functions; arguments are copied into the call
+namespace sql {
+
+template<typename... Args>
+[[nodiscard]] auto get(std::string_view db_key, std::string_view sql_query, Args&&... args) {
+    return run_blocking([db_key, sql_query, ...params = std::forward<Args>(args)] {
+        return ::sql::get(db_key, sql_query, params...);
+    });
+}
+
+template<typename... Args>
+[[nodiscard]] auto query(std::string_view db_key, std::string_view sql_query, Args&&... args) {
+    return run_blocking([db_key, sql_query, ...params = std::forward<Args>(args)] {
+        return ::sql::query(db_key, sql_query, params...);
+    });
+}
+
+template<typename... Args>
+[[nodiscard]] auto exec(std::string_view db_key, std::string_view sql_query, Args&&... args) {
+    return run_blocking([db_key, sql_query, ...params = std::forward<Args>(args)] {
+        ::sql::exec(db_key, sql_query, params...);
+    });
+}
+
+template<typename... Args>
+[[nodiscard]] auto get_json(std::string_view db_key, std::string_view sql_query, Args&&... args) {
+    return run_blocking([db_key, sql_query, ...params = std::forward<Args>(args)] {
+        return ::sql::get_json(db_key, sql_query, params...);
+    });
+}
+
+} // namespace sql
+
+} // namespace async
+
+#endif // ASYNC_SQL_HPP
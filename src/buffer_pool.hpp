@@ -0,0 +1,109 @@
+#ifndef BUFFER_POOL_HPP
+#define BUFFER_POOL_HPP
+
+#include <sys/mman.h>
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <span>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Per-reactor pool of fixed-size read buffers, carved out of large anonymous mappings.
+ *
+ * A connection only holds a block while it has unparsed bytes; idle keep-alive connections hold none.
+ * Blocks are acquired on the owning I/O thread and may be released on any thread, since a request
+ * carries its buffer to a worker: releases from other threads go to a mutex-guarded return list that
+ * the owner takes over in one swap when its own list runs dry, so steady state never hits the allocator.
+ * Slabs are never given back while the pool lives; they can optionally be backed by huge pages.
+ */
+class buffer_pool {
+public:
+    static constexpr size_t BLOCK_SIZE{4096};
+    static constexpr size_t SLAB_BLOCKS{512}; // 2 MB slabs, one huge page each
+
+    explicit buffer_pool(bool huge_pages = false) : m_huge_pages(huge_pages) {}
+
+    ~buffer_pool() noexcept {
+        for (const auto slab : m_slabs) {
+            munmap(slab.data(), slab.size());
+        }
+    }
+
+    buffer_pool(const buffer_pool&) = delete;
+    buffer_pool& operator=(const buffer_pool&) = delete;
+    buffer_pool(buffer_pool&&) = delete;
+    buffer_pool& operator=(buffer_pool&&) = delete;
+
+    // Releases on this thread skip the lock; call it from the reactor thread before it acquires anything
+    void bind_to_current_thread() noexcept {
+        m_owner = std::this_thread::get_id();
+    }
+
+    // Owner thread only
+    [[nodiscard]] char* acquire() {
+        if (m_free.empty()) {
+            const std::scoped_lock lock(m_returned_mutex);
+            m_free.swap(m_returned);
+        }
+        if (m_free.empty()) {
+            refill();
+        }
+        char* block = m_free.back();
+        m_free.pop_back();
+        return block;
+    }
+
+    // Any thread; never allocates, both lists have room for every block the pool owns
+    void release(char* block) noexcept {
+        if (std::this_thread::get_id() == m_owner) {
+            m_free.push_back(block);
+            return;
+        }
+        const std::scoped_lock lock(m_returned_mutex);
+        m_returned.push_back(block);
+    }
+
+    // Blocks owned by the pool, in use or not
+    [[nodiscard]] size_t capacity() const noexcept {
+        return m_slabs.size() * SLAB_BLOCKS;
+    }
+
+private:
+    // Owner thread, with m_free empty
+    void refill() {
+        constexpr size_t slab_size = BLOCK_SIZE * SLAB_BLOCKS;
+        void* slab = MAP_FAILED;
+        if (m_huge_pages) {
+            // Reserved hugetlbfs pages first, then transparent huge pages if none are configured
+            slab = mmap(nullptr, slab_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        }
+        if (slab == MAP_FAILED) {
+            slab = mmap(nullptr, slab_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (slab == MAP_FAILED) throw std::bad_alloc();
+            if (m_huge_pages) madvise(slab, slab_size, MADV_HUGEPAGE);
+        }
+        m_slabs.emplace_back(static_cast<char*>(slab), slab_size);
+
+        const size_t total = capacity();
+        m_free.reserve(total);
+        {
+            const std::scoped_lock lock(m_returned_mutex);
+            m_returned.reserve(total);
+        }
+        // Pushed in reverse so blocks are handed out in address order
+        for (size_t i = SLAB_BLOCKS; i > 0; --i) {
+            m_free.push_back(static_cast<char*>(slab) + (i - 1) * BLOCK_SIZE);
+        }
+    }
+
+    std::thread::id m_owner;
+    std::vector<char*> m_free;
+    std::mutex m_returned_mutex;
+    std::vector<char*> m_returned;
+    std::vector<std::span<char>> m_slabs;
+    bool m_huge_pages;
+};
+
+#endif // BUFFER_POOL_HPP
@@ -0,0 +1,207 @@
+#ifndef CONCURRENCY_LIMITER_HPP
+#define CONCURRENCY_LIMITER_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <utility>
+
+/**
+ * @brief Adaptive concurrency limit for one endpoint, in the style of Netflix's Gradient2 limiter.
+ *
+ * Requests are admitted while fewer than limit() are in flight. Completed requests report their latency,
+ * averaged over short windows; the window average is compared with a slow moving average of the same
+ * signal (the baseline). While they agree the limit grows by about sqrt(limit) per window; when latency
+ * rises above tolerance times the baseline the limit shrinks toward the concurrency that kept it there.
+ * Windows in which the endpoint used less than half of its limit leave the limit unchanged, since they
+ * say nothing about the capacity behind it. try_acquire() is lock-free; samples take a short lock.
+ */
+class concurrency_limiter {
+public:
+    struct options {
+        int initial_limit{32};
+        int min_limit{16};
+        int max_limit{1000};
+        std::chrono::milliseconds window{250};
+        int window_samples{10};
+        double tolerance{1.5}; // latency growth accepted before the limit shrinks
+        double smoothing{0.2};
+    };
+
+    explicit concurrency_limiter(const options& opts)
+        : m_options(opts),
+          m_estimate(static_cast<double>(std::clamp(opts.initial_limit, opts.min_limit, opts.max_limit))),
+          m_limit(static_cast<int>(m_estimate)),
+          m_window_start(std::chrono::steady_clock::now()) {
+    }
+
+    // Rule of 5: shared by every I/O thread, never copied or moved
+    concurrency_limiter(const concurrency_limiter&) = delete;
+    concurrency_limiter& operator=(const concurrency_limiter&) = delete;
+    concurrency_limiter(concurrency_limiter&&) = delete;
+    concurrency_limiter& operator=(concurrency_limiter&&) = delete;
+    ~concurrency_limiter() = default;
+
+    /**
+     * @brief Admits a request if the endpoint is below its limit.
+     * @return false if the request must be shed; every true must be paired with a release().
+     */
+    [[nodiscard]] bool try_acquire() noexcept {
+        int current = m_inflight.load(/* NOSONAR */ std::memory_order_relaxed);
+        do {
+            if (current >= m_limit.load(/* NOSONAR */ std::memory_order_relaxed)) {
+                m_rejected.fetch_add(1, /* NOSONAR */ std::memory_order_relaxed);
+                return false;
+            }
+        } while (!m_inflight.compare_exchange_weak(current, current + 1, /* NOSONAR */ std::memory_order_relaxed));
+        return true;
+    }
+
+    // Completes an admitted request and feeds its latency (admission to response) to the limit
+    void release(std::chrono::microseconds latency) {
+        const int inflight = m_inflight.fetch_sub(1, /* NOSONAR */ std::memory_order_relaxed);
+        record(latency, inflight);
+    }
+
+    // Completes an admitted request that produced no meaningful latency (e.g. dropped before running)
+    void release() noexcept {
+        m_inflight.fetch_sub(1, /* NOSONAR */ std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] int limit() const noexcept { return m_limit.load(/* NOSONAR */ std::memory_order_relaxed); }
+    [[nodiscard]] int inflight() const noexcept { return m_inflight.load(/* NOSONAR */ std::memory_order_relaxed); }
+    [[nodiscard]] uint64_t rejected() const noexcept { return m_rejected.load(/* NOSONAR */ std::memory_order_relaxed); }
+
+private:
+    static constexpr double LONG_WINDOWS{100.0}; // windows averaged by the long-term latency
+    static constexpr double MIN_LATENCY_US{1.0};
+
+    void record(std::chrono::microseconds latency, int inflight) {
+        std::scoped_lock lock(m_mutex);
+        m_window_sum_us += static_cast<double>(latency.count());
+        ++m_window_count;
+        m_window_max_inflight = std::max(m_window_max_inflight, inflight);
+
+        const auto now = std::chrono::steady_clock::now();
+        if (m_window_count < m_options.window_samples || now - m_window_start < m_options.window) {
+            return;
+        }
+        const double short_rtt = std::max(MIN_LATENCY_US, m_window_sum_us / m_window_count);
+        const int max_inflight = m_window_max_inflight;
+        m_window_start = now;
+        m_window_sum_us = 0.0;
+        m_window_count = 0;
+        m_window_max_inflight = 0;
+        update(short_rtt, max_inflight);
+    }
+
+    void update(double short_rtt, int max_inflight) {
+        if (m_long_rtt == 0.0) {
+            m_long_rtt = short_rtt;
+        } else {
+            // Congested windows move the baseline ten times slower, so sustained queueing cannot become the norm
+            const bool congested = short_rtt > m_options.tolerance * m_long_rtt;
+            m_long_rtt += (short_rtt - m_long_rtt) / (congested ? 10.0 * LONG_WINDOWS : LONG_WINDOWS);
+        }
+        // A steady latency drop (e.g. a recovered database) would otherwise pin the long-term value high
+        if (m_long_rtt / short_rtt > 2.0) {
+            m_long_rtt *= 0.95;
+        }
+
+        if (max_inflight < m_estimate / 2.0) {
+            return; // app-limited: the window did not probe the limit
+        }
+
+        const double gradient = std::clamp(m_options.tolerance * m_long_rtt / short_rtt, 0.5, 1.0);
+        const double target = m_estimate * gradient + std::sqrt(m_estimate);
+        m_estimate = std::clamp(m_estimate * (1.0 - m_options.smoothing) + target * m_options.smoothing,
+                                static_cast<double>(m_options.min_limit), static_cast<double>(m_options.max_limit));
+        m_limit.store(static_cast<int>(m_estimate), /* NOSONAR */ std::memory_order_relaxed);
+    }
+
+    const options m_options;
+
+    std::mutex m_mutex;
+    double m_estimate;
+    double m_long_rtt{0.0};
+    double m_window_sum_us{0.0};
+    int m_window_count{0};
+    int m_window_max_inflight{0};
+
+    std::atomic<int> m_limit;
+    std::atomic<int> m_inflight{0};
+    std::atomic<uint64_t> m_rejected{0};
+    std::chrono::steady_clock::time_point m_window_start;
+};
+
+/**
+ * @brief An admitted request's hold on its endpoint's limiter, given back exactly once.
+ *
+ * release() feeds the latency since admission to the limit; cancel() gives the slot back without a sample.
+ * A permit destroyed while still held releases itself with its latency, so a request that throws on its way
+ * through the server cannot shrink the endpoint's limit for good.
+ */
+class limiter_permit {
+public:
+    limiter_permit() = default;
+
+    // Admits against limiter; a null limiter admits every request and holds nothing
+    explicit limiter_permit(concurrency_limiter* limiter, std::chrono::steady_clock::time_point admitted_at)
+        : m_limiter(limiter), m_admitted_at(admitted_at) {
+        if (m_limiter != nullptr && !m_limiter->try_acquire()) {
+            m_limiter = nullptr;
+            m_admitted = false;
+        }
+    }
+
+    // Rule of 5: moving transfers the hold
+    limiter_permit(const limiter_permit&) = delete;
+    limiter_permit& operator=(const limiter_permit&) = delete;
+    limiter_permit(limiter_permit&& other) noexcept
+        : m_limiter(std::exchange(other.m_limiter, nullptr)), m_admitted_at(other.m_admitted_at), m_admitted(other.m_admitted) {
+    }
+    limiter_permit& operator=(limiter_permit&& other) noexcept {
+        if (this != &other) {
+            release();
+            m_limiter = std::exchange(other.m_limiter, nullptr);
+            m_admitted_at = other.m_admitted_at;
+            m_admitted = other.m_admitted;
+        }
+        return *this;
+    }
+    ~limiter_permit() noexcept {
+        release();
+    }
+
+    [[nodiscard]] bool admitted() const noexcept { return m_admitted; }
+    [[nodiscard]] std::chrono::steady_clock::time_point admitted_at() const noexcept { return m_admitted_at; }
+
+    // Queue wait included: it is where overload shows first
+    void release() noexcept {
+        if (concurrency_limiter* limiter = std::exchange(m_limiter, nullptr)) {
+            try {
+                limiter->release(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - m_admitted_at));
+            } catch (/* NOSONAR */ const std::exception&) {
+                // The slot was already given back; only the sample is lost
+            }
+        }
+    }
+
+    // For a request dropped before it ran: its latency says nothing about the endpoint
+    void cancel() noexcept {
+        if (concurrency_limiter* limiter = std::exchange(m_limiter, nullptr)) {
+            limiter->release();
+        }
+    }
+
+private:
+    concurrency_limiter* m_limiter{nullptr};
+    std::chrono::steady_clock::time_point m_admitted_at{};
+    bool m_admitted{true};
+};
+
+#endif // CONCURRENCY_LIMITER_HPP
@@ -0,0 +1,205 @@
+#ifndef CPU_AFFINITY_HPP
+#define CPU_AFFINITY_HPP
+
+#include "logger.hpp"
+#include "util.hpp"
+#include <linux/filter.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/socket.h>
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Placement of I/O workers and their thread pools on CPUs, plus SO_REUSEPORT steering.
+ *
+ * With a mode other than none, each io_worker gets a CPU for its reactor thread and a CPU set for its
+ * worker pool, and the reuseport group gets a classic BPF program that hands a new connection to the
+ * listener of the reactor owning the CPU that received it. Connection data then stays on one core
+ * (core) or one NUMA node (numa) from the NIC queue to the handler.
+ */
+namespace affinity {
+
+    enum class mode { none, core, numa };
+
+    struct placement {
+        std::vector<int> cpus;      // new connections received here go to this worker; its reactor runs on the first
+        std::vector<int> pool_cpus; // worker pool threads
+
+        [[nodiscard]] bool pinned() const noexcept { return !cpus.empty(); }
+    };
+
+    namespace detail {
+        // Parses a sysfs CPU list such as "0-3,8,10-11"
+        [[nodiscard]] inline std::vector<int> parse_cpu_list(std::string_view list) {
+            std::vector<int> cpus;
+            while (!list.empty()) {
+                const auto comma = list.find(',');
+                const auto item = list.substr(0, comma);
+                list = comma == std::string_view::npos ? std::string_view{} : list.substr(comma + 1);
+
+                int first = 0;
+                auto [ptr, ec] = std::from_chars(item.data(), item.data() + item.size(), first);
+                if (ec != std::errc{}) continue;
+                int last = first;
+                if (ptr != item.data() + item.size() && *ptr == '-') {
+                    std::from_chars(ptr + 1, item.data() + item.size(), last);
+                }
+                for (int cpu = first; cpu <= last; ++cpu) cpus.push_back(cpu);
+            }
+            return cpus;
+        }
+
+        // CPUs this process may run on (cgroup cpusets and taskset included)
+        [[nodiscard]] inline std::vector<int> allowed_cpus() {
+            std::vector<int> cpus;
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+                for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+                    if (CPU_ISSET(cpu, &set)) cpus.push_back(cpu);
+                }
+            }
+            return cpus;
+        }
+
+        // Allowed CPUs grouped by NUMA node; a single group when sysfs exposes no nodes
+        [[nodiscard]] inline std::vector<std::vector<int>> numa_nodes(const std::vector<int>& allowed) {
+            std::map<int, std::vector<int>> nodes;
+            std::error_code ec;
+            for (const auto& entry : std::filesystem::directory_iterator("/sys/devices/system/node", ec)) {
+                const std::string name = entry.path().filename().string();
+                int id = 0;
+                if (!name.starts_with("node") || std::from_chars(name.data() + 4, name.data() + name.size(), id).ec != std::errc{}) {
+                    continue;
+                }
+                std::ifstream file(entry.path() / "cpulist");
+                std::string list;
+                std::getline(file, list);
+                for (const int cpu : parse_cpu_list(list)) {
+                    if (std::ranges::binary_search(allowed, cpu)) nodes[id].push_back(cpu);
+                }
+            }
+
+            std::vector<std::vector<int>> groups;
+            for (auto& [id, cpus] : nodes) {
+                if (!cpus.empty()) groups.push_back(std::move(cpus));
+            }
+            if (groups.empty()) groups.push_back(allowed);
+            return groups;
+        }
+
+        // Splits cpus into count contiguous, nearly equal chunks; chunks repeat CPUs when count exceeds them
+        [[nodiscard]] inline std::vector<std::vector<int>> split(const std::vector<int>& cpus, size_t count) {
+            std::vector<std::vector<int>> chunks(count);
+            if (count <= cpus.size()) {
+                for (size_t i = 0; i < cpus.size(); ++i) chunks[i * count / cpus.size()].push_back(cpus[i]);
+            } else {
+                for (size_t i = 0; i < count; ++i) chunks[i].push_back(cpus[i % cpus.size()]);
+            }
+            return chunks;
+        }
+    }
+
+    [[nodiscard]] inline mode parse_mode(std::string_view value) {
+        if (value == "core") return mode::core;
+        if (value == "numa") return mode::numa;
+        if (value != "none" && !value.empty()) {
+            util::log::warn("Unknown CPU_AFFINITY '{}', running without CPU affinity.", value);
+        }
+        return mode::none;
+    }
+
+    /**
+     * @brief Computes one placement per I/O worker.
+     * @details core: the allowed CPUs are split into contiguous groups, one per worker; the reactor runs
+     * on the first CPU of its group and the pool on the whole group. numa: workers are spread round-robin
+     * over NUMA nodes and split their node's CPUs between them; the pool floats over the whole node, so
+     * its allocations stay node-local. Returns unpinned placements for mode::none.
+     */
+    [[nodiscard]] inline std::vector<placement> plan(mode m, int workers) {
+        std::vector<placement> result(static_cast<size_t>(std::max(workers, 0)));
+        const auto allowed = detail::allowed_cpus();
+        if (m == mode::none || allowed.empty() || result.empty()) return result;
+
+        if (m == mode::core) {
+            const auto groups = detail::split(allowed, result.size());
+            for (size_t i = 0; i < result.size(); ++i) {
+                result[i] = {groups[i], groups[i]};
+            }
+            return result;
+        }
+
+        const auto nodes = detail::numa_nodes(allowed);
+        std::vector<std::vector<size_t>> members(nodes.size());
+        for (size_t i = 0; i < result.size(); ++i) members[i % nodes.size()].push_back(i);
+        for (size_t n = 0; n < nodes.size(); ++n) {
+            if (members[n].empty()) continue;
+            const auto groups = detail::split(nodes[n], members[n].size());
+            for (size_t k = 0; k < members[n].size(); ++k) {
+                result[members[n][k]] = {groups[k], nodes[n]};
+            }
+        }
+        return result;
+    }
+
+    // Restricts the calling thread to cpus; threads it creates afterwards inherit the mask
+    inline bool pin_current_thread(std::span<const int> cpus) {
+        if (cpus.empty()) return true;
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (const int cpu : cpus) CPU_SET(cpu, &set);
+        if (const int rc = pthread_setaffinity_np(pthread_self(), sizeof(set), &set); rc != 0) {
+            util::log::warn("Failed to set CPU affinity: {}", util::str_error_cpp(rc));
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Attaches a reuseport program choosing the listener by the CPU that received the SYN.
+     * @details Listener k of the group must belong to placements[k]; a CPU shared by several placements
+     * goes to the first one. CPUs owned by no placement fall back to cpu % listeners.
+     */
+    inline bool attach_reuseport_steering(int listening_fd, std::span<const placement> placements) {
+        std::map<int, uint32_t> owner;
+        for (size_t i = 0; i < placements.size(); ++i) {
+            for (const int cpu : placements[i].cpus) owner.try_emplace(cpu, static_cast<uint32_t>(i));
+        }
+        if (owner.empty() || owner.size() * 2 + 3 > BPF_MAXINSNS) return false;
+
+        std::vector<sock_filter> code;
+        code.reserve(owner.size() * 2 + 3);
+        code.push_back(BPF_STMT(BPF_LD | BPF_W | BPF_ABS, static_cast<uint32_t>(SKF_AD_OFF + SKF_AD_CPU)));
+        for (const auto& [cpu, index] : owner) {
+            code.push_back(BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, static_cast<uint32_t>(cpu), 0, 1));
+            code.push_back(BPF_STMT(BPF_RET | BPF_K, index));
+        }
+        code.push_back(BPF_STMT(BPF_ALU | BPF_MOD | BPF_K, static_cast<uint32_t>(placements.size())));
+        code.push_back(BPF_STMT(BPF_RET | BPF_A, 0));
+
+        const sock_fprog program{static_cast<unsigned short>(code.size()), code.data()};
+        if (setsockopt(listening_fd, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &program, sizeof(program)) == -1) {
+            util::log::warn("Failed to attach SO_REUSEPORT CPU steering: {}", util::str_error_cpp(errno));
+            return false;
+        }
+        return true;
+    }
+
+    // Removes a steering program left on the group by a previous server process (see listener_handoff.hpp)
+    inline void detach_reuseport_steering(int listening_fd) noexcept {
+        int unused = 0;
+        setsockopt(listening_fd, SOL_SOCKET, SO_DETACH_REUSEPORT_BPF, &unused, sizeof(unused));
+    }
+}
+
+#endif // CPU_AFFINITY_HPP
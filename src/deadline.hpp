@@ -0,0 +1,64 @@
+#ifndef DEADLINE_HPP
+#define DEADLINE_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <optional>
+
+/**
+ * @brief The deadline of the request being handled on the current thread.
+ *
+ * The server sets it around an API handler; blocking calls made by the handler (SQL statements,
+ * remote HTTP calls) read it to bound their own timeouts, so work nobody will wait for is cut short.
+ * Threads without a deadline scope, and requests without a deadline, see no limit.
+ */
+namespace util::deadline {
+
+using clock = std::chrono::steady_clock;
+
+namespace detail {
+    inline thread_local clock::time_point g_deadline = clock::time_point::max();
+}
+
+/**
+ * @class scope
+ * @brief A RAII helper to set and clear the thread-local deadline.
+ */
+class scope {
+public:
+    explicit scope(clock::time_point deadline) noexcept {
+        detail::g_deadline = deadline;
+    }
+    ~scope() noexcept {
+        detail::g_deadline = clock::time_point::max();
+    }
+    // Non-copyable and non-movable
+    scope(const scope&) = delete;
+    scope& operator=(const scope&) = delete;
+    scope(scope&&) = delete;
+    scope& operator=(scope&&) = delete;
+};
+
+// The current thread's deadline; time_point::max() when there is none
+[[nodiscard]] inline clock::time_point current() noexcept {
+    return detail::g_deadline;
+}
+
+[[nodiscard]] inline bool active() noexcept {
+    return detail::g_deadline != clock::time_point::max();
+}
+
+[[nodiscard]] inline bool expired() noexcept {
+    return active() && clock::now() >= detail::g_deadline;
+}
+
+// Time left, zero once expired; nullopt when there is no deadline
+[[nodiscard]] inline std::optional<std::chrono::milliseconds> remaining() noexcept {
+    if (!active()) return std::nullopt;
+    const auto left = std::chrono::ceil<std::chrono::milliseconds>(detail::g_deadline - clock::now());
+    return std::max(left, std::chrono::milliseconds::zero());
+}
+
+} // namespace util::deadline
+
+#endif // DEADLINE_HPP
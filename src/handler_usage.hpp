@@ -0,0 +1,105 @@
+#ifndef HANDLER_USAGE_HPP
+#define HANDLER_USAGE_HPP
+
+#include <sys/resource.h>
+#include <time.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+/**
+ * @brief Where a handler's time goes: on the CPU, or waiting on databases, remote calls and locks.
+ *
+ * A probe reads the calling thread's CPU clock and context-switch counters before and after a handler;
+ * endpoint_usage sums the differences per endpoint. CPU time close to wall time means the endpoint computes
+ * and more cores help; wall time well above it, with voluntary switches, means it waits and more database
+ * connections (or a faster remote service) help. Involuntary switches are preemptions: more runnable
+ * threads than CPUs.
+ */
+namespace handler_usage {
+
+struct sample {
+    std::chrono::microseconds wall{0};
+    std::chrono::microseconds cpu{0};
+    uint64_t voluntary_switches{0};
+    uint64_t involuntary_switches{0};
+};
+
+/**
+ * @class probe
+ * @brief Measures one handler run on the current thread; start() and stop() must run on the same thread.
+ */
+class probe {
+public:
+    [[nodiscard]] static probe start() noexcept {
+        return probe(read());
+    }
+
+    [[nodiscard]] sample stop() const noexcept {
+        const reading end = read();
+        return {
+            std::chrono::duration_cast<std::chrono::microseconds>(end.wall - m_start.wall),
+            end.cpu - m_start.cpu,
+            static_cast<uint64_t>(end.voluntary - m_start.voluntary),
+            static_cast<uint64_t>(end.involuntary - m_start.involuntary)
+        };
+    }
+
+private:
+    struct reading {
+        std::chrono::steady_clock::time_point wall;
+        std::chrono::microseconds cpu{0};
+        long voluntary{0};
+        long involuntary{0};
+    };
+
+    explicit probe(const reading& start) noexcept : m_start(start) {}
+
+    // A failed call reads as zero on both sides, so the sample simply shows nothing for it
+    static reading read() noexcept {
+        reading r{std::chrono::steady_clock::now()};
+        if (timespec ts{}; clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0) {
+            r.cpu = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec));
+        }
+        if (rusage ru{}; getrusage(RUSAGE_THREAD, &ru) == 0) {
+            r.voluntary = ru.ru_nvcsw;
+            r.involuntary = ru.ru_nivcsw;
+        }
+        return r;
+    }
+
+    reading m_start;
+};
+
+/**
+ * @class endpoint_usage
+ * @brief Running totals for one endpoint, shared by every thread that runs its handler.
+ */
+class endpoint_usage {
+public:
+    void record(const sample& s) noexcept {
+        m_requests.fetch_add(1, /* NOSONAR */ std::memory_order_relaxed);
+        m_wall_us.fetch_add(static_cast<uint64_t>(s.wall.count()), /* NOSONAR */ std::memory_order_relaxed);
+        m_cpu_us.fetch_add(static_cast<uint64_t>(s.cpu.count()), /* NOSONAR */ std::memory_order_relaxed);
+        m_voluntary.fetch_add(s.voluntary_switches, /* NOSONAR */ std::memory_order_relaxed);
+        m_involuntary.fetch_add(s.involuntary_switches, /* NOSONAR */ std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] uint64_t requests() const noexcept { return m_requests.load(/* NOSONAR */ std::memory_order_relaxed); }
+    [[nodiscard]] uint64_t wall_us() const noexcept { return m_wall_us.load(/* NOSONAR */ std::memory_order_relaxed); }
+    [[nodiscard]] uint64_t cpu_us() const noexcept { return m_cpu_us.load(/* NOSONAR */ std::memory_order_relaxed); }
+    [[nodiscard]] uint64_t voluntary_switches() const noexcept { return m_voluntary.load(/* NOSONAR */ std::memory_order_relaxed); }
+    [[nodiscard]] uint64_t involuntary_switches() const noexcept { return m_involuntary.load(/* NOSONAR */ std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> m_requests{0};
+    std::atomic<uint64_t> m_wall_us{0};
+    std::atomic<uint64_t> m_cpu_us{0};
+    std::atomic<uint64_t> m_voluntary{0};
+    std::atomic<uint64_t> m_involuntary{0};
+};
+
+} // namespace handler_usage
+
+#endif // HANDLER_USAGE_HPP
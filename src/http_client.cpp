@@ -6,10 +6,16 @@
  */
 
 #include "http_client.hpp"
+#include "deadline.hpp"
+#include "task.hpp"
 #include <curl/curl.h>
+#include <algorithm>
 #include <iostream>
 #include <utility>
 #include <limits>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
 #include <functional> // For std::less
 #include <cstdlib>    // for std::abort
 #include <format> 
@@ -58,13 +64,16 @@ public:
                                               const std::optional<std::string>& post_body,
                                               const std::optional<std::vector<http_form_part>>& form_parts,
                                               const std::map<std::string, std::string, std::less<>>& headers);
+
+    // Shared with async_http_client, which configures its own easy handles
+    static void configure_common_options(CURL* curl, const http_client_config& config, const std::string& url, http_response& response);
+    [[nodiscard]] static curl_slist* build_headers(const std::map<std::string, std::string, std::less<>>& headers);
+    static void configure_post_body(CURL* curl, const std::string& post_body);
+
 private:
     http_client_config m_config;
     CURL* m_curl{nullptr};
 
-    void configure_common_options(const std::string& url, http_response& response) const;
-    [[nodiscard]] curl_slist* build_headers(const std::map<std::string, std::string, std::less<>>& headers) const;
-    void configure_post_body(const std::string& post_body) const;
     [[nodiscard]] curl_mime* build_multipart_form(const std::vector<http_form_part>& form_parts) const;
     
     static size_t write_callback(const char* ptr, size_t size, size_t nmemb, /* NOSONAR */ void* userdata);
@@ -127,31 +136,43 @@ size_t http_client::impl::header_callback(const char* buffer, size_t size, size_
     return size * nitems;
 }
 
-void http_client::impl::configure_common_options(const std::string& url, http_response& response) const {
+void http_client::impl::configure_common_options(CURL* curl, const http_client_config& config, const std::string& url, http_response& response) {
     static constexpr const char* user_agent = "cpp-http-client/1.0";
     static constexpr long follow_redirects = 1L;
 
-    curl_easy_setopt(m_curl, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(m_curl, CURLOPT_CONNECTTIMEOUT_MS, m_config.connect_timeout_ms);
-    curl_easy_setopt(m_curl, CURLOPT_TIMEOUT_MS, m_config.request_timeout_ms);
-    curl_easy_setopt(m_curl, CURLOPT_SSLVERSION, CURL_SSLVERSION_TLSv1_2);
-    curl_easy_setopt(m_curl, CURLOPT_FOLLOWLOCATION, follow_redirects);
-    curl_easy_setopt(m_curl, CURLOPT_USERAGENT, user_agent);
-    curl_easy_setopt(m_curl, CURLOPT_WRITEFUNCTION, write_callback);
-    curl_easy_setopt(m_curl, CURLOPT_WRITEDATA, &response.body);
-    curl_easy_setopt(m_curl, CURLOPT_HEADERFUNCTION, header_callback);
-    curl_easy_setopt(m_curl, CURLOPT_HEADERDATA, &response.headers);
-    curl_easy_setopt(m_curl, CURLOPT_NOSIGNAL, 1L);
-    curl_easy_setopt(m_curl, CURLOPT_TCP_KEEPALIVE, 1L);
-    curl_easy_setopt(m_curl, CURLOPT_TCP_KEEPIDLE, 30L);
-    curl_easy_setopt(m_curl, CURLOPT_TCP_KEEPINTVL, 60L);
+    // A call made for a request never outlives that request's deadline
+    long connect_timeout_ms = config.connect_timeout_ms;
+    long request_timeout_ms = config.request_timeout_ms;
+    if (const auto left = util::deadline::remaining()) {
+        if (left->count() == 0) {
+            throw curl_exception(std::format("Request deadline exceeded before calling URL {}", url));
+        }
+        const auto left_ms = static_cast<long>(left->count());
+        connect_timeout_ms = std::min(connect_timeout_ms, left_ms);
+        request_timeout_ms = std::min(request_timeout_ms, left_ms);
+    }
+
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT_MS, connect_timeout_ms);
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, request_timeout_ms);
+    curl_easy_setopt(curl, CURLOPT_SSLVERSION, CURL_SSLVERSION_TLSv1_2);
+    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, follow_redirects);
+    curl_easy_setopt(curl, CURLOPT_USERAGENT, user_agent);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_callback);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response.body);
+    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, header_callback);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, &response.headers);
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPIDLE, 30L);
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPINTVL, 60L);
     
-    if (m_config.client_cert_path) curl_easy_setopt(m_curl, CURLOPT_SSLCERT, m_config.client_cert_path->c_str());
-    if (m_config.client_key_path) curl_easy_setopt(m_curl, CURLOPT_SSLKEY, m_config.client_key_path->c_str());
-    if (m_config.client_key_password) curl_easy_setopt(m_curl, CURLOPT_KEYPASSWD, m_config.client_key_password->c_str());
+    if (config.client_cert_path) curl_easy_setopt(curl, CURLOPT_SSLCERT, config.client_cert_path->c_str());
+    if (config.client_key_path) curl_easy_setopt(curl, CURLOPT_SSLKEY, config.client_key_path->c_str());
+    if (config.client_key_password) curl_easy_setopt(curl, CURLOPT_KEYPASSWD, config.client_key_password->c_str());
 }
 
-[[nodiscard]] curl_slist* http_client::impl::build_headers(const std::map<std::string, std::string, std::less<>>& headers) const {
+[[nodiscard]] curl_slist* http_client::impl::build_headers(const std::map<std::string, std::string, std::less<>>& headers) {
     curl_slist* header_list = nullptr;
     for (const auto& [key, value] : headers) {
         std::string header_string = key + ": " + value;
@@ -160,12 +181,12 @@ void http_client::impl::configure_common_options(const std::string& url, http_re
     return header_list;
 }
 
-void http_client::impl::configure_post_body(const std::string& post_body) const {
+void http_client::impl::configure_post_body(CURL* curl, const std::string& post_body) {
     if (const size_t body_length = post_body.length(); body_length > static_cast<size_t>(std::numeric_limits<long>::max())) {
         throw curl_exception("POST body is too large to be handled by libcurl.");
     }
-    curl_easy_setopt(m_curl, CURLOPT_POSTFIELDS, post_body.c_str());
-    curl_easy_setopt(m_curl, CURLOPT_POSTFIELDSIZE, static_cast<long>(post_body.length()));
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, post_body.c_str());
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, static_cast<long>(post_body.length()));
 }
 
 [[nodiscard]] curl_mime* http_client::impl::build_multipart_form(const std::vector<http_form_part>& form_parts) const {
@@ -207,7 +228,7 @@ void http_client::impl::configure_post_body(const std::string& post_body) const
     
     http_response response{};
     
-    configure_common_options(url, response);
+    configure_common_options(m_curl, m_config, url, response);
 
     if (header_list_ptr) {
         curl_easy_setopt(m_curl, CURLOPT_HTTPHEADER, header_list_ptr.get());
@@ -217,7 +238,7 @@ void http_client::impl::configure_post_body(const std::string& post_body) const
         mime_ptr.reset(build_multipart_form(*form_parts));
         curl_easy_setopt(m_curl, CURLOPT_MIMEPOST, mime_ptr.get());
     } else if (post_body) {
-        configure_post_body(*post_body);
+        configure_post_body(m_curl, *post_body);
     }
 
     if (CURLcode res = curl_easy_perform(m_curl); res != CURLE_OK) {
@@ -246,3 +267,190 @@ http_client& http_client::operator=(http_client&&) noexcept = default;
 [[nodiscard]] http_response http_client::post(const std::string& url, const std::vector<http_form_part>& form_parts, const std::map<std::string, std::string, std::less<>>& headers) {
     return pimpl_->perform_request(url, std::nullopt, form_parts, headers);
 }
+
+// ===================================================================
+//         async_http_client Implementation
+// ===================================================================
+
+// One call in flight: the easy handle and everything libcurl reads or writes while it runs
+class async_http_client::transfer {
+public:
+    explicit transfer(CURL* easy) noexcept : m_easy(easy) {}
+
+    ~transfer() {
+        curl_easy_cleanup(m_easy);
+        curl_slist_free_all(m_headers);
+    }
+
+    transfer(const transfer&) = delete;
+    transfer& operator=(const transfer&) = delete;
+    transfer(transfer&&) = delete;
+    transfer& operator=(transfer&&) = delete;
+
+    // On the loop thread, once the handle has left the multi handle
+    void complete(CURLcode result) {
+        m_result = result;
+        if (result == CURLE_OK) {
+            curl_easy_getinfo(m_easy, CURLINFO_RESPONSE_CODE, &m_response.status_code);
+        }
+        // The resumed coroutine destroys this transfer when it moves past the await
+        const async::resume_context context = *m_context;
+        const std::coroutine_handle<> handle = m_handle;
+        context.resume(handle);
+    }
+
+    CURL* m_easy;
+    curl_slist* m_headers{nullptr};
+    std::string m_url;
+    std::string m_body; // CURLOPT_POSTFIELDS points into it
+    http_response m_response{};
+    CURLcode m_result{CURLE_OK};
+    std::coroutine_handle<> m_handle;
+    std::optional<async::resume_context> m_context;
+};
+
+namespace {
+
+// Drives every async_http_client transfer of the process on one libcurl multi handle, from its own thread
+class curl_multi_loop {
+public:
+    static curl_multi_loop& instance() {
+        static curl_multi_loop loop;
+        return loop;
+    }
+
+    ~curl_multi_loop() {
+        m_thread.request_stop();
+        curl_multi_wakeup(m_multi);
+        m_thread.join();
+        curl_multi_cleanup(m_multi);
+    }
+
+    curl_multi_loop(const curl_multi_loop&) = delete;
+    curl_multi_loop& operator=(const curl_multi_loop&) = delete;
+    curl_multi_loop(curl_multi_loop&&) = delete;
+    curl_multi_loop& operator=(curl_multi_loop&&) = delete;
+
+    // Any thread; the transfer completes on the loop thread
+    void add(async_http_client::transfer* t) {
+        {
+            const std::scoped_lock lock(m_mutex);
+            m_incoming.push_back(t);
+        }
+        curl_multi_wakeup(m_multi);
+    }
+
+private:
+    static constexpr int POLL_TIMEOUT_MS{1000};
+
+    curl_multi_loop() : m_multi(curl_multi_init()) {
+        if (!m_multi) {
+            throw curl_exception("Failed to create CURL multi handle.");
+        }
+        m_thread = std::jthread([this](const std::stop_token& stop) { run(stop); });
+    }
+
+    void run(const std::stop_token& stop) {
+        int running = 0;
+        while (!stop.stop_requested()) {
+            add_incoming();
+            curl_multi_perform(m_multi, &running);
+            complete_finished();
+            curl_multi_poll(m_multi, nullptr, 0, POLL_TIMEOUT_MS, nullptr);
+        }
+        // Shutting down: fail what is left, so no handler waits forever
+        add_incoming();
+        for (async_http_client::transfer* t : std::exchange(m_active, {})) {
+            curl_multi_remove_handle(m_multi, t->m_easy);
+            t->complete(CURLE_ABORTED_BY_CALLBACK);
+        }
+    }
+
+    void add_incoming() {
+        std::vector<async_http_client::transfer*> incoming;
+        {
+            const std::scoped_lock lock(m_mutex);
+            incoming.swap(m_incoming);
+        }
+        for (async_http_client::transfer* t : incoming) {
+            if (curl_multi_add_handle(m_multi, t->m_easy) != CURLM_OK) {
+                t->complete(CURLE_FAILED_INIT);
+                continue;
+            }
+            m_active.insert(t);
+        }
+    }
+
+    void complete_finished() {
+        int queued = 0;
+        while (const CURLMsg* msg = curl_multi_info_read(m_multi, &queued)) {
+            if (msg->msg != CURLMSG_DONE) continue;
+            CURL* easy = msg->easy_handle;
+            const CURLcode result = msg->data.result;
+            char* priv = nullptr;
+            curl_easy_getinfo(easy, CURLINFO_PRIVATE, &priv);
+            auto* t = reinterpret_cast<async_http_client::transfer*>(priv); // NOSONAR: set by prepare()
+            curl_multi_remove_handle(m_multi, easy); // invalidates msg
+            m_active.erase(t);
+            t->complete(result); // the handler may start new transfers: they wait in m_incoming
+        }
+    }
+
+    CURLM* m_multi;
+    std::mutex m_mutex;
+    std::vector<async_http_client::transfer*> m_incoming; // guarded by m_mutex
+    std::unordered_set<async_http_client::transfer*> m_active; // loop thread only
+    std::jthread m_thread;
+};
+
+} // namespace
+
+async_http_client::awaiter::awaiter(std::unique_ptr<transfer> t) noexcept : m_transfer(std::move(t)) {}
+async_http_client::awaiter::~awaiter() noexcept = default;
+async_http_client::awaiter::awaiter(awaiter&&) noexcept = default;
+async_http_client::awaiter& async_http_client::awaiter::operator=(awaiter&&) noexcept = default;
+
+void async_http_client::awaiter::await_suspend(std::coroutine_handle<> handle) {
+    m_transfer->m_handle = handle;
+    m_transfer->m_context.emplace(async::resume_context::capture());
+    curl_multi_loop::instance().add(m_transfer.get());
+}
+
+http_response async_http_client::awaiter::await_resume() {
+    if (m_transfer->m_result != CURLE_OK) {
+        throw curl_exception(std::format("curl transfer failed for URL {} - {}", m_transfer->m_url, curl_easy_strerror(m_transfer->m_result)));
+    }
+    return std::move(m_transfer->m_response);
+}
+
+async_http_client::async_http_client(http_client_config config) : m_config(std::move(config)) {}
+
+[[nodiscard]] async_http_client::awaiter async_http_client::get(const std::string& url, const std::map<std::string, std::string, std::less<>>& headers) const {
+    return prepare(url, std::nullopt, headers);
+}
+
+[[nodiscard]] async_http_client::awaiter async_http_client::post(const std::string& url, std::string body, const std::map<std::string, std::string, std::less<>>& headers) const {
+    return prepare(url, std::move(body), headers);
+}
+
+async_http_client::awaiter async_http_client::prepare(const std::string& url, std::optional<std::string> body,
+                                                      const std::map<std::string, std::string, std::less<>>& headers) const {
+    CURL* easy = curl_easy_init();
+    if (!easy) {
+        throw curl_exception("Failed to create CURL easy handle.");
+    }
+    auto t = std::make_unique<transfer>(easy);
+    t->m_url = url;
+    // Bounded by the deadline of the request being handled, like http_client
+    http_client::impl::configure_common_options(easy, m_config, t->m_url, t->m_response);
+    t->m_headers = http_client::impl::build_headers(headers);
+    if (t->m_headers) {
+        curl_easy_setopt(easy, CURLOPT_HTTPHEADER, t->m_headers);
+    }
+    if (body) {
+        t->m_body = std::move(*body);
+        http_client::impl::configure_post_body(easy, t->m_body);
+    }
+    curl_easy_setopt(easy, CURLOPT_PRIVATE, t.get());
+    return awaiter(std::move(t));
+}
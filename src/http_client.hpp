@@ -14,6 +14,7 @@
 #include <stdexcept>
 #include <optional>
 #include <memory>
+#include <coroutine>
 #include <functional> // For std::less
 #include <variant>    // For std::variant
 
@@ -131,8 +132,65 @@ public:
     [[nodiscard]] http_response post(const std::string& url, const std::vector<http_form_part>& form_parts, const std::map<std::string, std::string, std::less<>>& headers = {});
 
 private:
+    friend class async_http_client; // shares the request setup
     class impl;
     std::unique_ptr<impl> pimpl_;
 };
 
+/**
+ * @class async_http_client
+ * @brief Non-blocking REST calls for coroutine handlers: co_await client.get(url).
+ * @details All transfers of the process share one libcurl multi handle driven by a background thread,
+ * so thousands of slow upstream calls can be in flight without a thread each. The awaiting handler
+ * resumes on that thread: keep the work between awaits short, or move it to async::run_blocking().
+ */
+class async_http_client {
+public:
+    class transfer;
+
+    /**
+     * @class awaiter
+     * @brief A prepared call; co_await starts it and yields the http_response or throws curl_exception.
+     */
+    class awaiter {
+    public:
+        explicit awaiter(std::unique_ptr<transfer> t) noexcept;
+        ~awaiter() noexcept;
+        awaiter(awaiter&&) noexcept;
+        awaiter& operator=(awaiter&&) noexcept;
+        awaiter(const awaiter&) = delete;
+        awaiter& operator=(const awaiter&) = delete;
+
+        [[nodiscard]] bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle);
+        http_response await_resume();
+
+    private:
+        std::unique_ptr<transfer> m_transfer;
+    };
+
+    /**
+     * @brief Constructs a client; timeouts and certificates apply as in http_client.
+     */
+    explicit async_http_client(http_client_config config = {});
+
+    /**
+     * @brief Prepares an HTTP GET request.
+     * @throws curl_exception if the request's deadline already passed.
+     */
+    [[nodiscard]] awaiter get(const std::string& url, const std::map<std::string, std::string, std::less<>>& headers = {}) const;
+
+    /**
+     * @brief Prepares an HTTP POST request with a raw string body.
+     * @throws curl_exception if the body is too large or the request's deadline already passed.
+     */
+    [[nodiscard]] awaiter post(const std::string& url, std::string body, const std::map<std::string, std::string, std::less<>>& headers = {}) const;
+
+private:
+    [[nodiscard]] awaiter prepare(const std::string& url, std::optional<std::string> body,
+                                  const std::map<std::string, std::string, std::less<>>& headers) const;
+
+    http_client_config m_config;
+};
+
 #endif // HTTP_CLIENT_H
\ No newline at end of file
@@ -6,6 +6,7 @@
 #include <locale> 
 #include <memory> 
 #include <algorithm> // for search
+#include <limits>
 
 using namespace std::literals::string_view_literals;
 
@@ -15,30 +16,18 @@ namespace {
 // tchar = "!" / "#" / "$" / "%" / "&" / "'" / "*"
 //       / "+" / "-" / "." / "^" / "_" / "`" / "|" / "~"
 //       / DIGIT / ALPHA
-inline bool is_valid_header_key(std::string_view key) {
-    if (key.empty()) {
-        return false;
-    }
-    constexpr std::string_view valid_tchars =
-        "!#$%&'*+-.^_`|~"
-        "0123456789"
-        "abcdefghijklmnopqrstuvwxyz"
-        "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
-    
-    // Scoped initializer for SonarCloud compliance
-    if (auto pos = key.find_first_not_of(valid_tchars); pos != std::string_view::npos) {
-        return false;
-    }
-    return true;
-}
+constexpr auto tchars = util::text::char_class::of(
+    "!#$%&'*+-.^_`|~"
+    "0123456789"
+    "abcdefghijklmnopqrstuvwxyz"
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZ");
 
 // Per RFC 7230, field-value can be complex, but for security,
 // we *must* prohibit bare CR and LF to prevent response splitting.
+constexpr auto line_breaks = util::text::char_class::of("\r\n");
+
 inline bool is_valid_header_value(std::string_view value) {
-    if (auto pos = value.find_first_of("\r\n"sv); pos != std::string_view::npos) {
-        return false;
-    }
-    return true;
+    return util::text::find_first_of(value, line_breaks) == std::string_view::npos;
 }
 
 // --- NEW HELPERS for Path Validation ---
@@ -47,6 +36,8 @@ constexpr size_t MAX_PATH_LENGTH = 2048;
 // Validates against path traversal and other bad characters.
 // We are explicitly disallowing URL-encoded characters ('%') in the path
 // to block a class of obfuscation attacks.
+constexpr auto invalid_path_chars = util::text::char_class::of("%\0\r\n\\"sv);
+
 inline bool is_valid_path(std::string_view path) {
     if (path.empty()) {
         return false;
@@ -56,8 +47,8 @@ inline bool is_valid_path(std::string_view path) {
         return false; // Must be an absolute path starting with '/'
     }
 
-    // Check for invalid characters using init-statement
-    if (constexpr std::string_view invalid_chars = "%\0\r\n\\"sv; path.find_first_of(invalid_chars) != std::string_view::npos) {
+    // Check for invalid characters
+    if (util::text::find_first_of(path, invalid_path_chars) != std::string_view::npos) {
         return false;
     }
 
@@ -90,6 +81,68 @@ inline std::string_view sanitize_filename(std::string_view filename) {
 
 namespace http {
 
+// ===================================================================
+//         header_map: Implementation
+// ===================================================================
+
+namespace {
+    // Indexed by header_id
+    constexpr std::array<std::string_view, static_cast<size_t>(header_id::other)> well_known_headers{
+        "Host"sv, "Content-Length"sv, "Content-Type"sv, "Transfer-Encoding"sv, "Authorization"sv, "Origin"sv,
+        "X-Request-ID"sv, "X-Request-Timeout"sv, "X-Forwarded-For"sv, "Range"sv, "If-Modified-Since"sv
+    };
+}
+
+// Most names differ in length from every well-known one, which iequals() rejects without reading them
+auto header_map::identify(std::string_view name) noexcept -> header_id {
+    for (size_t i = 0; i < well_known_headers.size(); ++i) {
+        if (util::text::iequals(name, well_known_headers[i])) {
+            return static_cast<header_id>(i);
+        }
+    }
+    return header_id::other;
+}
+
+void header_map::add(size_t name_offset, size_t name_size, size_t value_offset, size_t value_size, header_id id) {
+    const entry e{static_cast<uint32_t>(name_offset), static_cast<uint32_t>(name_size),
+                  static_cast<uint32_t>(value_offset), static_cast<uint32_t>(value_size), id};
+    if (m_size < INLINE_CAPACITY) {
+        m_inline[m_size] = e;
+    } else {
+        if (m_spill.empty()) {
+            m_spill.reserve(INLINE_CAPACITY * 2);
+            m_spill.assign(m_inline.begin(), m_inline.end());
+        }
+        m_spill.push_back(e);
+    }
+    if (id != header_id::other && m_slots[static_cast<size_t>(id)] == NO_SLOT) {
+        m_slots[static_cast<size_t>(id)] = static_cast<uint8_t>(m_size);
+    }
+    ++m_size;
+}
+
+auto header_map::find(header_id id) const noexcept -> std::optional<std::string_view> {
+    if (id == header_id::other) {
+        return std::nullopt;
+    }
+    if (const auto slot = m_slots[static_cast<size_t>(id)]; slot != NO_SLOT) {
+        return field(slot).value;
+    }
+    return std::nullopt;
+}
+
+auto header_map::find(std::string_view name) const noexcept -> std::optional<std::string_view> {
+    if (const auto id = identify(name); id != header_id::other) {
+        return find(id);
+    }
+    for (size_t i = 0; i < m_size; ++i) {
+        if (const auto f = field(i); util::text::iequals(f.name, name)) {
+            return f.value;
+        }
+    }
+    return std::nullopt;
+}
+
 // ===================================================================
 //         request_parser: Implementation
 // ===================================================================
@@ -215,51 +268,108 @@ void request_parser::process_multipart_part(std::string_view part_sv) {
     }
 }
 
-auto request_parser::get_buffer() noexcept -> std::span<char> {
-    return m_buffer->buffer();
+auto request_parser::attach(buffer_pool* pool) -> void {
+    m_buffer.attach(pool);
+}
+
+auto request_parser::attached() const noexcept -> bool {
+    return m_buffer.attached();
+}
+
+// A parser nobody attached to a pool reads into a heap buffer
+auto request_parser::get_buffer() -> std::span<char> {
+    m_buffer.attach(nullptr);
+    return m_buffer.buffer();
+}
+
+auto request_parser::has_data() const noexcept -> bool {
+    return !m_buffer.empty();
+}
+
+auto request_parser::headers_complete() -> bool {
+    return eof() || m_state == parse_state::body;
+}
+
+// Only the smaller side is copied: the request when pipelined requests follow it, otherwise the few
+// bytes past it. A burst of N requests costs O(N) copying, and a lone request none at all.
+auto request_parser::take_request(buffer_pool* pool) -> request_parser {
+    const size_t size = m_buffer.size();
+    // Nothing after a malformed request can be framed, so it takes everything
+    const size_t length = m_error ? size : std::min(m_headerSize + m_contentLength, size);
+    request_parser taken(std::move(*this));
+    *this = request_parser{};
+    if (length == size) {
+        return taken;
+    }
+    const auto bytes = taken.m_buffer.view();
+    if (size - length <= length) {
+        m_buffer = socket_buffer(bytes.substr(length), pool);
+    } else {
+        socket_buffer own(bytes.substr(0, length), pool);
+        m_buffer = std::move(taken.m_buffer);
+        m_buffer.consume(length);
+        taken.m_buffer = std::move(own);
+    }
+    return taken;
+}
+
+void request_parser::compact() noexcept {
+    m_buffer.compact();
 }
 
 void request_parser::update_pos(ssize_t bytes_read) {
     if (m_isFinalized) {
         return;
     }
-    m_buffer->update_pos(bytes_read);
+    m_buffer.update_pos(bytes_read);
 }
 
-// --- MODIFIED eof() ---
-// Enables early detection of unknown methods so we don't hang waiting for body data
+// Scans only the bytes read since the last call, so a request trickled in small segments costs O(n) in total.
+// A malformed request also counts as complete, so finalize() can report it without waiting for more data.
 auto request_parser::eof() -> bool {
-    using enum http::method;
-
-    if (!find_and_store_header_end()) {
-        return false;
-    }
-    if (!parse_and_store_method()) {
-        return false;
-    }
-    
-    // UPDATED: If method is unknown, consider request complete (headers-only)
-    // so we can reject it in finalize().
-    if (m_identifiedMethod == unknown) {
-        return true; 
-    }
-
-    if (m_identifiedMethod == get || m_identifiedMethod == options) {
+    if (m_state == parse_state::complete) {
         return true;
     }
-    
-    if (m_identifiedMethod == post) {
-        parse_and_store_content_length();
-        if (!m_identifiedContentLength.has_value()) {
-            return true; // Malformed or missing Content-Length: trigger finalize() to fail
+    const auto data = m_buffer.view();
+    while (m_state == parse_state::request_line || m_state == parse_state::headers) {
+        const auto lf = data.find('\n', m_scanPos);
+        if (lf == std::string_view::npos) {
+            m_scanPos = data.size();
+            return false;
+        }
+        m_scanPos = lf + 1;
+        const size_t line_start = std::exchange(m_lineStart, m_scanPos);
+
+        // A bare LF could let a proxy in front of us frame the request differently
+        if (lf == line_start || data[lf - 1] != '\r') {
+            return fail(request_parse_error("Malformed request: line not terminated by CRLF."));
+        }
+        const auto line = data.substr(line_start, lf - 1 - line_start);
+
+        std::optional<request_parse_error> err;
+        if (m_state == parse_state::request_line) {
+            if (line.empty()) {
+                continue; // RFC 9112: empty lines before the request line are ignored
+            }
+            err = parse_request_line(line, line_start);
+        } else if (line.empty()) {
+            m_headerSize = m_scanPos;
+            err = end_headers();
+        } else {
+            err = parse_header_line(line, line_start);
+        }
+        if (err) {
+            return fail(std::move(*err));
         }
-        return m_buffer->size() >= (*m_identifiedHeaderSize + *m_identifiedContentLength);
     }
 
-    return false;
+    if (m_buffer.size() < m_headerSize + m_contentLength) {
+        return false;
+    }
+    m_state = parse_state::complete;
+    return true;
 }
 
-// --- MODIFIED finalize() ---
 // Triggers the exception (error) for non-compliant methods
 auto request_parser::finalize() -> std::expected<void, request_parse_error> {
     using enum http::method;
@@ -271,53 +381,34 @@ auto request_parser::finalize() -> std::expected<void, request_parse_error> {
     if (!eof()) {
         return std::unexpected(request_parse_error("Attempted to finalize before request reached eof()."));
     }
+    if (m_error) {
+        return std::unexpected(*m_error);
+    }
 
-    const auto request_sv = m_buffer->view();
-    
-    if (const auto first_line_end_pos = request_sv.find("\r\n"sv); first_line_end_pos == std::string_view::npos) {
-        return std::unexpected(request_parse_error("Malformed request: request line not found."));
-    } else {
-        if (auto err = parse_request_line(request_sv.substr(0, first_line_end_pos))) {
-            return std::unexpected(*err);
-        }
-        
-        m_parsedMethod = m_identifiedMethod.value_or(unknown);
+    // Strictly reject unsupported methods here
+    if (m_parsedMethod == unknown) {
+        // This error message will be caught by server.cpp and sent as a 400 Bad Request
+        return std::unexpected(request_parse_error("Method Not Allowed or Unsupported"));
+    }
 
-        // UPDATED: Strictly reject unsupported methods here
-        if (m_parsedMethod == unknown) {
-            // This error message will be caught by server.cpp and sent as a 400 Bad Request
-            return std::unexpected(request_parse_error("Method Not Allowed or Unsupported"));
+    // The request is complete and its buffer no longer moves: the stored offsets become views
+    const auto request_sv = m_buffer.view();
+    m_path = request_sv.substr(m_pathOffset, m_pathSize);
+    m_headers.bind(request_sv);
+
+    if (m_parsedMethod == post && m_contentLength > 0) {
+        const auto content_type = m_headers.find(header_id::content_type);
+        if (!content_type) {
+            return std::unexpected(request_parse_error("POST request with body is missing Content-Type header."));
         }
 
-        const auto headers_end_pos_marker = *m_identifiedHeaderSize - 4;
-        const auto headers_sv = request_sv.substr(first_line_end_pos + 2, headers_end_pos_marker - (first_line_end_pos + 2));
-        if (auto err = parse_headers(headers_sv)) {
-            return std::unexpected(*err);
+        if (!content_type->starts_with("application/json") && !content_type->starts_with("multipart/form-data")) {
+            return std::unexpected(request_parse_error(
+                std::format("Unsupported Content-Type for POST: {}", *content_type)
+            ));
         }
     }
-    
-    m_headerSize = *m_identifiedHeaderSize;
-
     if (m_parsedMethod == post) {
-        if (!m_identifiedContentLength.has_value()) {
-             return std::unexpected(request_parse_error("POST request without valid Content-Length header."));
-        }
-        m_contentLength = *m_identifiedContentLength;
-
-        if (m_contentLength > 0) {
-            auto it = m_headers.find("content-type");
-            if (it == m_headers.end()) {
-                return std::unexpected(request_parse_error("POST request with body is missing Content-Type header."));
-            }
-
-            const auto& content_type = it->second;
-            if (!content_type.starts_with("application/json") && !content_type.starts_with("multipart/form-data")) {
-                return std::unexpected(request_parse_error(
-                    std::format("Unsupported Content-Type for POST: {}", content_type)
-                ));
-            }
-        }
-        
         if (auto err = parse_body()) {
             return std::unexpected(*err);
         }
@@ -327,140 +418,42 @@ auto request_parser::finalize() -> std::expected<void, request_parse_error> {
     return {};
 }
 
-auto request_parser::find_and_store_header_end() -> bool {
-    if (m_identifiedHeaderSize.has_value()) {
-        return true;
-    }
-    const auto current_buffer_view = m_buffer->view();
-    
-    if (const auto headers_end_pos = current_buffer_view.find("\r\n\r\n"sv); headers_end_pos != std::string_view::npos) {
-        m_identifiedHeaderSize = headers_end_pos + 4;
-        return true;
-    }
-    
-    return false;
+auto request_parser::fail(request_parse_error error) -> bool {
+    m_error = std::move(error);
+    m_state = parse_state::complete;
+    return true;
 }
 
-// --- MODIFIED parse_and_store_method() ---
-// Returns TRUE even for unknown methods to allow parsing to proceed to failure state
-auto request_parser::parse_and_store_method() -> bool {
+// Identifies the method and validates the URI; offset is where the line starts in the buffer
+auto request_parser::parse_request_line(std::string_view request_line, size_t offset) -> std::optional<request_parse_error> {
     using enum http::method;
 
-    if (m_identifiedMethod.has_value()) {
-        return true;
-    }
-    if (!m_identifiedHeaderSize.has_value()) {
-        return false;
-    }
-
-    const auto current_buffer_view = m_buffer->view();
-    if (current_buffer_view.empty() || current_buffer_view.size() < *m_identifiedHeaderSize) {
-        return false;
+    const auto method_end = request_line.find(' ');
+    if (method_end == std::string_view::npos) {
+        return request_parse_error("Malformed request line: missing URI.");
     }
 
-    if (const auto request_line_end = current_buffer_view.find("\r\n"sv); request_line_end == std::string_view::npos || request_line_end == 0 || request_line_end >= (*m_identifiedHeaderSize - 4)) {
-        return false;
+    if (const std::string_view method_sv = request_line.substr(0, method_end); method_sv == "GET"sv) {
+        m_parsedMethod = get;
+    } else if (method_sv == "POST"sv) {
+        m_parsedMethod = post;
+    } else if (method_sv == "OPTIONS"sv) {
+        m_parsedMethod = options;
     } else {
-        const std::string_view request_line_sv = current_buffer_view.substr(0, request_line_end);
-        
-        if (const auto method_space_pos = request_line_sv.find(' '); method_space_pos == std::string_view::npos) {
-            // Malformed request line (no space), treat as unknown but incomplete? 
-            // Actually this is just garbage data.
-            m_identifiedMethod = unknown;
-            return false;
-        } else {
-            if (const std::string_view method_sv = request_line_sv.substr(0, method_space_pos); method_sv == "GET"sv) {
-                m_identifiedMethod = get;
-            } else if (method_sv == "POST"sv) {
-                m_identifiedMethod = post;
-            } else if (method_sv == "OPTIONS"sv) {
-                m_identifiedMethod = options;
-            } else {
-                util::log::warn("Received request with unknown method: '{}'", method_sv);
-                m_identifiedMethod = unknown;
-                // Important: Return TRUE here. We found a method token, we know what it is (unknown).
-                // Returning true allows eof() to return true, which allows process_request() to call finalize(),
-                // which allows us to return the error.
-                return true; 
-            }
-        }
-    }
-    
-    return m_identifiedMethod != unknown;
-}
-
-auto request_parser::parse_and_store_content_length() -> bool {
-    if (m_identifiedMethod != method::post) {
-        return true;
-    }
-    if (m_identifiedContentLength.has_value()) {
-        return true;
-    }
-    if (!m_identifiedHeaderSize.has_value()) {
-        return false;
-    }
-
-    const auto current_buffer_view = m_buffer->view();
-    
-    // Check request_line_end
-    const auto request_line_end = current_buffer_view.find("\r\n"sv);
-    if (request_line_end == std::string_view::npos) {
-        return false;
-    }
-
-    const size_t headers_part_start = request_line_end + 2;
-    const size_t headers_part_length = (*m_identifiedHeaderSize - 4) - headers_part_start;
-
-    if (headers_part_start >= *m_identifiedHeaderSize || headers_part_start + headers_part_length > current_buffer_view.size()) {
-        return false;
+        // Parsing goes on to the end of the headers; finalize() then rejects the method
+        util::log::warn("Received request with unknown method: '{}'", method_sv);
+        m_parsedMethod = unknown;
     }
 
-    std::string_view headers_part = current_buffer_view.substr(headers_part_start, headers_part_length);
-
-    for (const auto line_range : headers_part | std::views::split("\r\n"sv)) {
-        std::string_view header_line(line_range.begin(), line_range.end());
-        
-        auto colon_pos = header_line.find(':');
-        if (colon_pos == std::string_view::npos || !sv_ci_equal{}(header_line.substr(0, colon_pos), "Content-Length"sv)) {
-            continue;
-        }
-
-        // FIX 2: Use trim_sv to strip both leading and trailing spaces
-        std::string_view cl_value_sv = trim_sv(header_line.substr(colon_pos + 1));
-        
-        size_t temp_cl = 0;
-        auto [ptr, ec] = std::from_chars(cl_value_sv.data(), cl_value_sv.data() + cl_value_sv.size(), temp_cl);
-        
-        if (ec == std::errc() && ptr == cl_value_sv.data() + cl_value_sv.size()) {
-            m_identifiedContentLength = temp_cl;
-            return true;
-        }
-        
-        // FIX 1: Malformed Content-Length found. 
-        // Break out and return true. Leaving m_identifiedContentLength empty 
-        // safely signals to eof() and finalize() to throw a 400 Bad Request.
-        break; 
-    }
-    
-    return true; 
-}
-
-auto request_parser::parse_request_line(std::string_view request_line) -> std::optional<request_parse_error> {
-    auto parts = request_line | std::views::split(' ') | std::views::common;
-    auto it = parts.begin();
-    if (it == parts.end()) {
-        return request_parse_error("Malformed request line: empty.");
-    }
-    ++it;
-    if (it == parts.end()) {
-        return request_parse_error("Malformed request line: missing URI.");
-    }
-    
-    const std::string_view uri_sv(std::to_address((*it).begin()), std::ranges::distance(*it));
-    
-    if (auto err = parse_uri(uri_sv); err.has_value()) {
+    // The URI is the second token; the protocol version after it is not checked
+    auto uri = request_line.substr(method_end + 1);
+    uri = uri.substr(0, uri.find(' '));
+    if (auto err = parse_uri(uri)) {
         return err;
     }
+    m_pathOffset = offset + method_end + 1;
+    m_pathSize = uri.size();
+    m_state = parse_state::headers;
     return std::nullopt;
 }
 
@@ -476,75 +469,107 @@ auto request_parser::parse_uri(std::string_view uri) -> std::optional<request_pa
         return request_parse_error(std::format("URI exceeds maximum length of {}. URI: '{}'", MAX_PATH_LENGTH, uri));
     }
 
-    // 3. Set path (entire URI is path since no '?')
-    m_path = uri;
-
-    // 4. Validate the path characters
-    if (!is_valid_path(m_path)) {
+    // 3. Validate the path characters (entire URI is path since no '?')
+    if (!is_valid_path(uri)) {
         return request_parse_error(std::format("Invalid URI path: contains forbidden characters or traversal sequences. URI: '{}'", uri));
     }
 
     return std::nullopt;
 }
 
-auto request_parser::parse_headers(std::string_view headers_sv) -> std::optional<request_parse_error> {
+// Validates one header line as soon as it is complete and records where its key and value are
+auto request_parser::parse_header_line(std::string_view header_line, size_t offset) -> std::optional<request_parse_error> {
     constexpr size_t MAX_HEADERS = 50; // maximum header limit
 
-    for (const auto line_range : headers_sv | std::views::split("\r\n"sv)) {
-        std::string_view header_line(line_range.begin(), line_range.end());
-        if (header_line.empty()) {
-            continue;
-        }
+    // Fast-fail defense against Hash DoS attacks
+    if (m_headers.size() >= MAX_HEADERS) {
+        return request_parse_error("Too many headers: maximum limit exceeded.");
+    }
+
+    // header_map keeps 32-bit offsets
+    if (offset + header_line.size() > std::numeric_limits<uint32_t>::max()) {
+        return request_parse_error("Header block too large.");
+    }
 
-        // Fast-fail defense against Hash DoS attacks
-        if (m_headers.size() >= MAX_HEADERS) {
-            return request_parse_error("Too many headers: maximum limit exceeded.");
+    // One scan finds the colon and validates the key: the key ends at its first non-token byte
+    const auto pos = util::text::find_first_not_of(header_line, tchars);
+    if (pos == std::string_view::npos || header_line[pos] != ':') {
+        if (!header_line.contains(':')) {
+            return request_parse_error(std::format("Malformed header line: {}", header_line));
         }
+        return request_parse_error(std::format("Invalid header key: {}", header_line.substr(0, header_line.find(':'))));
+    }
 
-        if (auto pos = header_line.find(':'); pos != std::string_view::npos) {
-            auto key = header_line.substr(0, pos);
-            
-            if (!is_valid_header_key(key)) {
-                return request_parse_error(std::format("Invalid header key: {}", key));
-            }
-            
-            auto value = trim_sv(header_line.substr(pos + 1));
+    const auto key = header_line.substr(0, pos);
+    if (key.empty()) {
+        return request_parse_error(std::format("Invalid header key: {}", key));
+    }
 
-            if (!is_valid_header_value(value)) {
-                return request_parse_error(std::format("Invalid characters in header value for key: {}", key));
-            }
+    const auto value = trim_sv(header_line.substr(pos + 1));
+    if (!is_valid_header_value(value)) {
+        return request_parse_error(std::format("Invalid characters in header value for key: {}", key));
+    }
 
-            // Security: Reject Transfer-Encoding (HSR protection)
-            if (sv_ci_equal{}(key, "Transfer-Encoding")) {
-                return request_parse_error("Transfer-Encoding is not supported.");
-            }
-            
-            // Security: Reject duplicate Host and Content-Length headers
-            if (sv_ci_equal{}(key, "Host") && m_headers.contains("Host")) {
-                return request_parse_error("Duplicate Host header detected.");
-            }
-            if (sv_ci_equal{}(key, "Content-Length") && m_headers.contains("Content-Length")) {
-                return request_parse_error("Duplicate Content-Length header detected.");
-            }
-            
-            m_headers.try_emplace(std::string(key), value);
-        } else {
-            return request_parse_error(std::format("Malformed header line: {}", header_line));
+    const auto id = header_map::identify(key);
+
+    // Security: Reject Transfer-Encoding (HSR protection)
+    if (id == header_id::transfer_encoding) {
+        return request_parse_error("Transfer-Encoding is not supported.");
+    }
+
+    // Security: Reject duplicate Host and Content-Length headers
+    if (id == header_id::host) {
+        if (m_seenHost) {
+            return request_parse_error("Duplicate Host header detected.");
+        }
+        m_seenHost = true;
+    }
+    if (id == header_id::content_length) {
+        if (m_seenContentLength) {
+            return request_parse_error("Duplicate Content-Length header detected.");
+        }
+        m_seenContentLength = true;
+        // Parsed for every method: a body left unread would be taken for the next pipelined request
+        size_t length = 0;
+        if (auto [ptr, ec] = std::from_chars(value.data(), value.data() + value.size(), length);
+            ec != std::errc() || ptr != value.data() + value.size()) {
+            return request_parse_error(std::format("Invalid Content-Length: {}", value));
+        }
+        // Only a POST body is read; any other request with a body is refused rather than framed
+        if (m_parsedMethod != method::post && length > 0) {
+            return request_parse_error("Only POST requests may carry a body.");
+        }
+        // The body has to fit in the read buffer anyway; the bound also keeps m_headerSize + m_contentLength from wrapping
+        if (length > socket_buffer::get_max_size()) {
+            return request_parse_error(std::format("Content-Length {} exceeds MAX_REQUEST_SIZE.", length));
         }
+        m_contentLength = length;
+        m_validContentLength = true;
     }
+
+    const auto value_offset = offset + static_cast<size_t>(value.data() - header_line.data());
+    m_headers.add(offset, key.size(), value_offset, value.size(), id);
+    return std::nullopt;
+}
+
+auto request_parser::end_headers() -> std::optional<request_parse_error> {
+    if (m_parsedMethod == method::post && !m_validContentLength) {
+        return request_parse_error("POST request without valid Content-Length header.");
+    }
+    m_state = parse_state::body;
     return std::nullopt;
 }
 
 auto request_parser::parse_body() -> std::optional<request_parse_error> {
-    const auto body_view = m_buffer->view().substr(m_headerSize, m_contentLength);
-    auto it = m_headers.find("content-type");
+    const auto body_view = m_buffer.view().substr(m_headerSize, m_contentLength);
+    const auto content_type_header = m_headers.find(header_id::content_type);
 
-    if (it == m_headers.end()) {
+    if (!content_type_header) {
         m_body = body_view;
         return std::nullopt;
     }
     
-    const auto& content_type = it->second;
+    const auto content_type = *content_type_header;
     if (content_type.starts_with("application/json"sv)) {
         try {
             m_jsonPayload = std::make_unique<json::json_parser>(body_view);
@@ -577,7 +602,7 @@ auto request_parser::parse_body() -> std::optional<request_parse_error> {
 
 auto request_parser::parse_multipart_form_data(std::string_view boundary) -> std::optional<request_parse_error> {
     const std::string full_boundary = "--" + std::string(boundary);
-    const auto body_view = m_buffer->view().substr(m_headerSize, m_contentLength);
+    const auto body_view = m_buffer.view().substr(m_headerSize, m_contentLength);
     
     for (const auto part_range : body_view | std::views::split(full_boundary) | std::views::drop(1)) {
         process_multipart_part({std::to_address(part_range.begin()), static_cast<size_t>(std::ranges::distance(part_range))});
@@ -602,8 +627,8 @@ request::request(request_parser&& parser, std::string_view remote_ip)
       m_remote_ip(remote_ip)
 {
     // If X-Forwarded-For exists, use the first IP in the list as the real remote IP.
-    if (auto it = m_headers.find("X-Forwarded-For"); it != m_headers.end()) {
-        std::string_view forwarded = it->second;
+    if (const auto header = m_headers.find(header_id::x_forwarded_for)) {
+        std::string_view forwarded = *header;
         // The header can be "client_ip, proxy1, proxy2". We want the first one.
         if (auto comma_pos = forwarded.find(','); comma_pos != std::string_view::npos) {
             m_remote_ip = trim_sv(forwarded.substr(0, comma_pos)); // You need a string copy if m_remote_ip is std::string
@@ -630,22 +655,27 @@ auto request::get_remote_ip() const noexcept -> std::string_view {
 }
 
 auto request::get_header_value(std::string_view key) const noexcept -> std::optional<std::string_view> {
-    if (auto it = m_headers.find(key); it != m_headers.end()) {
-        return it->second;
-    }
-    return std::nullopt;
+    return m_headers.find(key);
+}
+
+auto request::get_header_value(header_id id) const noexcept -> std::optional<std::string_view> {
+    return m_headers.find(id);
 }
 
 auto request::get_headers() const noexcept -> const header_map& { return m_headers; }
 auto request::get_params() const noexcept -> const param_map& { return m_params; }
 auto request::get_body() const noexcept -> const request_body& { return m_body; }
 auto request::get_path() const noexcept -> std::string_view { return m_path; }
+
+void request::set_path_param(std::string_view name) {
+    m_params.insert_or_assign(name, m_path.substr(m_path.rfind('/') + 1));
+}
 auto request::get_file_parts() const noexcept -> const std::vector<multipart_item>& { return m_fileParts; }
 
 auto request::get_bearer_token() const noexcept -> std::optional<std::string_view> {
-    if (auto it = m_headers.find("Authorization"); 
-        it != m_headers.end() && (it->second.starts_with("Bearer "sv) || it->second.starts_with("bearer "sv))) {
-        return it->second.substr(7);
+    if (const auto header = m_headers.find(header_id::authorization);
+        header && (header->starts_with("Bearer "sv) || header->starts_with("bearer "sv))) {
+        return header->substr(7);
     }    
     return std::nullopt;
 }
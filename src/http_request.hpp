@@ -3,6 +3,7 @@
 
 #include "socket_buffer.hpp"
 #include "json_parser.hpp"
+#include "text_scan.hpp"
 #include <string_view>
 #include <unordered_map>
 #include <variant>
@@ -20,33 +21,120 @@
 #include <span>
 #include <memory>
 #include <utility>
+#include <cstdint>
+#include <array>
 
 namespace http {
 
 // --- Type Definitions (must come before classes that use them) ---
 
-struct sv_ci_hash {
+struct sv_ci_equal {
     using is_transparent = void;
-    [[nodiscard]] auto operator()(std::string_view sv) const noexcept -> size_t {
-        size_t hash = 5381;
-        for (const auto c : sv) {
-            hash = ((hash << 5) + hash) + static_cast<size_t>(std::tolower(static_cast<unsigned char>(c)));
-        }
-        return hash;
+    [[nodiscard]] auto operator()(std::string_view lhs, std::string_view rhs) const noexcept -> bool {
+        return util::text::iequals(lhs, rhs);
     }
 };
 
-struct sv_ci_equal {
-    using is_transparent = void;
-    [[nodiscard]] auto operator()(std::string_view lhs, std::string_view rhs) const noexcept -> bool {
-        return lhs.size() == rhs.size() &&
-               std::equal(lhs.begin(), lhs.end(), rhs.begin(), [](char a, char b) {
-                   return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b));
-               });
+// Headers the server reads itself; the parser identifies them once, so lookups by ID compare no names
+enum class header_id : uint8_t {
+    host,
+    content_length,
+    content_type,
+    transfer_encoding,
+    authorization,
+    origin,
+    x_request_id,
+    x_request_timeout,
+    x_forwarded_for,
+    range,
+    if_modified_since,
+    other
+};
+
+struct header_field {
+    std::string_view name;
+    std::string_view value;
+};
+
+/**
+ * @class header_map
+ * @brief The request headers, in arrival order, as offsets into the request buffer.
+ * @details The parser adds each header as its line arrives, while the buffer may still move; bind() points
+ * the map at the complete request. Up to INLINE_CAPACITY headers are stored inside the object, so a
+ * typical request keeps its headers without a heap allocation. Each well-known header also has a slot
+ * indexed by header_id. When a header repeats, lookups return its first occurrence.
+ */
+class header_map {
+    struct entry {
+        uint32_t name_offset;
+        uint32_t name_size;
+        uint32_t value_offset;
+        uint32_t value_size;
+        header_id id;
+    };
+
+public:
+    static constexpr size_t INLINE_CAPACITY = 16;
+
+    class const_iterator {
+    public:
+        using value_type = header_field;
+        using difference_type = std::ptrdiff_t;
+
+        const_iterator() = default;
+        const_iterator(const header_map* map, size_t index) noexcept : m_map(map), m_index(index) {}
+
+        [[nodiscard]] auto operator*() const noexcept -> header_field { return m_map->field(m_index); }
+        auto operator++() noexcept -> const_iterator& { ++m_index; return *this; }
+        auto operator++(int) noexcept -> const_iterator { auto prev = *this; ++m_index; return prev; }
+        [[nodiscard]] auto operator==(const const_iterator& other) const noexcept -> bool = default;
+
+    private:
+        const header_map* m_map{nullptr};
+        size_t m_index{0};
+    };
+
+    // The header_id of a header name, case-insensitively; header_id::other if it is not well known
+    [[nodiscard]] static auto identify(std::string_view name) noexcept -> header_id;
+
+    void add(size_t name_offset, size_t name_size, size_t value_offset, size_t value_size, header_id id);
+
+    // Offsets added so far are relative to the start of request
+    void bind(std::string_view request) noexcept { m_base = request; }
+
+    [[nodiscard]] auto find(header_id id) const noexcept -> std::optional<std::string_view>;
+    [[nodiscard]] auto find(std::string_view name) const noexcept -> std::optional<std::string_view>;
+
+    [[nodiscard]] auto size() const noexcept -> size_t { return m_size; }
+    [[nodiscard]] auto empty() const noexcept -> bool { return m_size == 0; }
+    [[nodiscard]] auto begin() const noexcept -> const_iterator { return {this, 0}; }
+    [[nodiscard]] auto end() const noexcept -> const_iterator { return {this, m_size}; }
+
+private:
+    static constexpr uint8_t NO_SLOT = 0xff;
+    using slot_array = std::array<uint8_t, static_cast<size_t>(header_id::other)>;
+
+    static constexpr auto init_slots() noexcept -> slot_array {
+        slot_array slots{};
+        slots.fill(NO_SLOT);
+        return slots;
+    }
+
+    [[nodiscard]] auto at(size_t index) const noexcept -> const entry& {
+        return m_spill.empty() ? m_inline[index] : m_spill[index];
     }
+    [[nodiscard]] auto field(size_t index) const noexcept -> header_field {
+        const auto& e = at(index);
+        return {m_base.substr(e.name_offset, e.name_size), m_base.substr(e.value_offset, e.value_size)};
+    }
+
+    std::array<entry, INLINE_CAPACITY> m_inline{};
+    std::vector<entry> m_spill; // all entries, once there are more than INLINE_CAPACITY
+    slot_array m_slots{init_slots()};
+    size_t m_size{0};
+    std::string_view m_base;
 };
 
-using header_map = std::unordered_map<std::string, std::string_view, sv_ci_hash, sv_ci_equal>;
 using param_map = std::unordered_map<std::string_view, std::string_view>;
 
 struct multipart_item {
@@ -98,7 +186,11 @@ public:
     [[nodiscard]] auto get_file_upload(std::string_view field_name) const noexcept -> const multipart_item*;
 	// New helper to get an arbitrary header value	
     [[nodiscard]] auto get_header_value(std::string_view key) const noexcept -> std::optional<std::string_view>;
+    // Same for a well-known header, without comparing names
+    [[nodiscard]] auto get_header_value(header_id id) const noexcept -> std::optional<std::string_view>;
     [[nodiscard]] auto get_json_payload() const noexcept -> const json::json_parser* { return m_jsonPayload.get(); }
+    // Exposes the last path segment as a parameter, for a route like /download/{name}; name must outlive the request
+    void set_path_param(std::string_view name);
 
     template <typename t>
     [[nodiscard]] auto get_value(std::string_view param_name) const noexcept -> std::expected<std::optional<t>, param_error>;
@@ -132,7 +224,7 @@ public:
     [[nodiscard]] auto get_sessionId() const noexcept -> std::string;
     
 private:
-    std::unique_ptr<socket_buffer> m_buffer;
+    socket_buffer m_buffer;
     std::unique_ptr<json::json_parser> m_jsonPayload;
     method m_method{method::unknown};
     header_map m_headers;
@@ -188,10 +280,19 @@ public:
     request_parser(const request_parser&) = delete;
     request_parser& operator=(const request_parser&) = delete;
 
-    [[nodiscard]] auto get_buffer() noexcept -> std::span<char>;
+    // Buffers are attached lazily, when the first bytes arrive, so an idle parser holds no memory
+    auto attach(buffer_pool* pool) -> void;
+    [[nodiscard]] auto attached() const noexcept -> bool;
+    [[nodiscard]] auto get_buffer() -> std::span<char>;
     void update_pos(ssize_t bytes_read);
     [[nodiscard]] auto eof() -> bool;
     [[nodiscard]] auto finalize() -> std::expected<void, request_parse_error>;
+    [[nodiscard]] auto has_data() const noexcept -> bool;
+    [[nodiscard]] auto headers_complete() -> bool;
+    // Once eof(): splits the complete request off, leaving this parser on the bytes read past it
+    [[nodiscard]] auto take_request(buffer_pool* pool) -> request_parser;
+    // Reclaims the room of requests taken out of the buffer; once per batch of pipelined requests
+    void compact() noexcept;
 
 private:
     struct multipart_part_headers {
@@ -200,12 +301,14 @@ private:
         std::optional<std::string_view> content_type;
     };
 
-    auto find_and_store_header_end() -> bool;
-    auto parse_and_store_method() -> bool;
-    auto parse_and_store_content_length() -> bool;
-    auto parse_headers(std::string_view headers_sv) -> std::optional<request_parse_error>;
-    auto parse_request_line(std::string_view request_line) -> std::optional<request_parse_error>;
-    auto parse_uri(std::string_view uri) -> std::optional<request_parse_error>;
+    // Where the scan stands between reads: complete also covers a request found malformed
+    enum class parse_state : uint8_t { request_line, headers, body, complete };
+
+    auto fail(request_parse_error error) -> bool;
+    auto parse_request_line(std::string_view request_line, size_t offset) -> std::optional<request_parse_error>;
+    auto parse_header_line(std::string_view header_line, size_t offset) -> std::optional<request_parse_error>;
+    auto end_headers() -> std::optional<request_parse_error>;
+    static auto parse_uri(std::string_view uri) -> std::optional<request_parse_error>;
     auto parse_body() -> std::optional<request_parse_error>;
     auto parse_multipart_form_data(std::string_view boundary) -> std::optional<request_parse_error>;
     void process_multipart_part(std::string_view part_sv);
@@ -214,13 +317,19 @@ private:
     // --- ADDED STATIC HELPER HERE ---
     static void process_parameter(std::string_view param, multipart_part_headers& headers);
 
-    std::unique_ptr<socket_buffer> m_buffer{std::make_unique<socket_buffer>()};
+    socket_buffer m_buffer;
     
     std::unique_ptr<json::json_parser> m_jsonPayload;
     method m_parsedMethod{method::unknown};
-    std::optional<method> m_identifiedMethod;
-    std::optional<size_t> m_identifiedContentLength;
-    std::optional<size_t> m_identifiedHeaderSize;
+    parse_state m_state{parse_state::request_line};
+    size_t m_scanPos{0};    // first byte not yet scanned for a line end
+    size_t m_lineStart{0};  // first byte of the line being scanned
+    size_t m_pathOffset{0};
+    size_t m_pathSize{0};
+    std::optional<request_parse_error> m_error;
+    bool m_seenHost{false};
+    bool m_seenContentLength{false};
+    bool m_validContentLength{false};
     header_map m_headers;
     param_map m_params;
     request_body m_body;
@@ -233,4 +342,4 @@ private:
 
 } // namespace http
 
-#endif // HTTP_REQUEST_HPP
\ No newline at end of file
+#endif // HTTP_REQUEST_HPP
\ No newline at end of file
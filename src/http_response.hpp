@@ -10,19 +10,34 @@
 #include <chrono>
 #include <cstddef>
 #include <stdexcept>
+#include <array>
+#include <memory>
+#include <variant>
+#include <concepts>
+#include <utility>
+#include <charconv>
+#include <sstream>
+#include <locale>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 namespace http {
 
 enum class status {
     ok = 200,
     no_content = 204,
+    partial_content = 206,
+    not_modified = 304,
     bad_request = 400,
     unauthorized = 401,
     forbidden = 403,
     not_found = 404,
     entity_too_large = 413,
+    range_not_satisfiable = 416,
     internal_server_error = 500,
-    service_unavailable = 503
+    service_unavailable = 503,
+    gateway_timeout = 504
 };
 
 [[nodiscard]] constexpr std::string_view to_reason_phrase(status s) {
@@ -30,13 +45,17 @@ enum class status {
     switch (s) {
         case ok: return "OK";
         case no_content: return "No Content";
+        case partial_content: return "Partial Content";
+        case not_modified: return "Not Modified";
         case bad_request: return "Bad Request";
         case unauthorized: return "Unauthorized";
         case forbidden: return "Forbidden";
         case not_found: return "Not Found";
         case entity_too_large: return "Entity Too Large";
+        case range_not_satisfiable: return "Range Not Satisfiable";
         case internal_server_error: return "Internal Server Error";
         case service_unavailable: return "Service Unavailable";
+        case gateway_timeout: return "Gateway Timeout";
     }
     return "Unknown Status";
 }
@@ -44,18 +63,140 @@ enum class status {
 // NOTE: The response_exception has been removed as it's an anti-pattern
 // to use exceptions for standard control flow like authentication failures.
 
+/**
+ * @brief An open file backing a response body; owns the descriptor.
+ * The server streams [offset, offset + length) to the socket with sendfile.
+ */
+class file_body {
+public:
+    file_body(int fd, off_t offset, size_t length) noexcept : m_fd(fd), m_offset(offset), m_length(length) {}
+    ~file_body() noexcept {
+        if (m_fd != -1) ::close(m_fd);
+    }
+    file_body(file_body&& other) noexcept
+        : m_fd(std::exchange(other.m_fd, -1)), m_offset(other.m_offset), m_length(other.m_length) {}
+    file_body& operator=(file_body&& other) noexcept {
+        if (this != &other) {
+            if (m_fd != -1) ::close(m_fd);
+            m_fd = std::exchange(other.m_fd, -1);
+            m_offset = other.m_offset;
+            m_length = other.m_length;
+        }
+        return *this;
+    }
+    file_body(const file_body&) = delete;
+    file_body& operator=(const file_body&) = delete;
+
+    [[nodiscard]] int fd() const noexcept { return m_fd; }
+    [[nodiscard]] int release() noexcept { return std::exchange(m_fd, -1); }
+    [[nodiscard]] off_t offset() const noexcept { return m_offset; }
+    [[nodiscard]] size_t length() const noexcept { return m_length; }
+
+private:
+    int m_fd{-1};
+    off_t m_offset{0};
+    size_t m_length{0};
+};
+
+// The part of a file body still to be sent
+struct file_chunk {
+    int fd;
+    off_t offset;
+    size_t length;
+};
+
+namespace detail {
+    // Inclusive byte range resolved against the file size
+    struct byte_range {
+        size_t first{0};
+        size_t last{0};
+        bool satisfiable{true};
+    };
+
+    [[nodiscard]] inline std::optional<size_t> parse_size(std::string_view s) noexcept {
+        size_t value{0};
+        const auto [ptr, ec] = std::from_chars(s.data(), s.data() + s.size(), value);
+        if (s.empty() || ec != std::errc{} || ptr != s.data() + s.size()) return std::nullopt;
+        return value;
+    }
+
+    // Single "bytes=first-last", "bytes=first-" or "bytes=-suffix" range. nullopt means
+    // serve the whole file: absent, malformed or multi-range headers are ignored (RFC 9110 14.2).
+    [[nodiscard]] inline std::optional<byte_range> parse_byte_range(std::string_view value, size_t size) noexcept {
+        constexpr std::string_view unit = "bytes=";
+        if (!value.starts_with(unit) || value.contains(',')) return std::nullopt;
+        value.remove_prefix(unit.size());
+        const auto dash = value.find('-');
+        if (dash == std::string_view::npos) return std::nullopt;
+        const auto first_sv = value.substr(0, dash);
+        const auto last_sv = value.substr(dash + 1);
+
+        if (first_sv.empty()) {
+            const auto suffix = parse_size(last_sv);
+            if (!suffix) return std::nullopt;
+            if (*suffix == 0 || size == 0) return byte_range{.satisfiable = false};
+            return byte_range{size > *suffix ? size - *suffix : 0, size - 1};
+        }
+        const auto first = parse_size(first_sv);
+        const auto last = last_sv.empty() ? first : parse_size(last_sv); // open-ended: runs to the end
+        if (!first || !last || *last < *first) return std::nullopt;
+        if (*first >= size) return byte_range{.satisfiable = false};
+        return byte_range{*first, last_sv.empty() ? size - 1 : std::min(*last, size - 1)};
+    }
+
+    // IMF-fixdate, e.g. "Sun, 06 Nov 1994 08:49:37 GMT"
+    [[nodiscard]] inline std::optional<std::chrono::sys_seconds> parse_http_date(std::string_view value) {
+        std::istringstream iss{std::string(value)};
+        iss.imbue(std::locale::classic());
+        std::chrono::sys_seconds tp{};
+        std::chrono::from_stream(iss, "%a, %d %b %Y %H:%M:%S GMT", tp);
+        if (iss.fail()) return std::nullopt;
+        return tp;
+    }
+}
+
+/**
+ * @brief An HTTP response kept as two parts: a small rendered header block and the body.
+ *
+ * The body is never copied into the header buffer. It is either owned (moved in, e.g. the JSON
+ * returned by sql::get), shared with other responses, or an open file. The server writes the
+ * header and in-memory bodies with a single writev, and streams file bodies with sendfile.
+ */
 class response {
 public:
     explicit response(std::optional<std::string_view> origin = std::nullopt);
     void set_body(status s, std::string_view body, std::string_view content_type = "application/json; charset=utf-8");
+    // Takes ownership of a temporary body instead of copying it
+    template<typename Body> requires std::same_as<Body, std::string>
+    void set_body(status s, Body&& body, std::string_view content_type = "application/json; charset=utf-8");
+    // Shares an immutable body, e.g. a cached document, across responses
+    void set_body(status s, std::shared_ptr<const std::string> body, std::string_view content_type = "application/json; charset=utf-8");
     void set_blob(std::string_view blob_data, std::string_view content_type, std::string_view content_disposition);
+    template<typename Blob> requires std::same_as<Blob, std::string>
+    void set_blob(Blob&& blob_data, std::string_view content_type, std::string_view content_disposition);
     void set_options();
-    [[nodiscard]] std::span<const char> buffer() const noexcept;
+    // Streams a file from disk; honours a single byte Range (206/416) and If-Modified-Since (304)
+    void set_file(const std::string& path, std::string_view content_type, std::string_view content_disposition,
+                  std::optional<std::string_view> range = std::nullopt,
+                  std::optional<std::string_view> if_modified_since = std::nullopt);
+    // Unsent parts of the header block and the body, in write order; either may be empty
+    [[nodiscard]] std::array<std::span<const char>, 2> buffers() const noexcept;
+    // True if the body is a file: buffers() then covers only the header block
+    [[nodiscard]] bool has_file() const noexcept;
+    // The unsent part of a file body, once the header block is out
+    [[nodiscard]] std::optional<file_chunk> pending_file() const noexcept;
     [[nodiscard]] size_t available_size() const noexcept;
     void update_pos(size_t bytes_sent) noexcept;
     [[nodiscard]] std::optional<status> status_code() const noexcept;
 private:
-    std::vector<char> m_buffer;
+    void write_headers(status s, std::string_view content_type, size_t content_length);
+    void write_blob_headers(std::string_view content_type, std::string_view content_disposition, size_t content_length);
+    void write_file_headers(status s, std::chrono::sys_seconds last_modified, std::string_view entity_headers);
+    [[nodiscard]] std::string_view body() const noexcept;
+    [[nodiscard]] size_t body_size() const noexcept;
+
+    std::string m_header;
+    std::variant<std::string, std::shared_ptr<const std::string>, file_body> m_body;
     size_t m_readPos{0};
     bool m_finalized{false};
     std::optional<std::string> m_origin;
@@ -68,11 +209,34 @@ inline response::response(std::optional<std::string_view> origin)
     if(origin && !origin->empty()) {
         m_origin = *origin;
     }
-    m_buffer.reserve(4096);
+    m_header.reserve(1024);
 }
 
 inline void response::set_body(status s, std::string_view body, std::string_view content_type) {
     if (m_finalized) return;
+    write_headers(s, content_type, body.size());
+    m_body = std::string(body);
+    m_finalized = true;
+}
+
+template<typename Body> requires std::same_as<Body, std::string>
+inline void response::set_body(status s, Body&& body, std::string_view content_type) {
+    if (m_finalized) return;
+    write_headers(s, content_type, body.size());
+    m_body = std::move(body);
+    m_finalized = true;
+}
+
+inline void response::set_body(status s, std::shared_ptr<const std::string> body, std::string_view content_type) {
+    if (m_finalized) return;
+    write_headers(s, content_type, body ? body->size() : 0);
+    if (body) {
+        m_body = std::move(body);
+    }
+    m_finalized = true;
+}
+
+inline void response::write_headers(status s, std::string_view content_type, size_t content_length) {
     // store the status for later retrieval
     m_status = s;    
     constexpr std::string_view format_template =
@@ -88,27 +252,38 @@ inline void response::set_body(status s, std::string_view body, std::string_view
         "Connection: keep-alive\r\n"
         "Content-Type: {}\r\n"
         "Content-Length: {}\r\n"
-        "\r\n"
-        "{}";
+        "\r\n";
 
     const auto cors_header = m_origin ? std::format("Access-Control-Allow-Origin: {}\r\nvary: Origin\r\n", *m_origin) : "";
     
     std::format_to(
-        std::back_inserter(m_buffer),
+        std::back_inserter(m_header),
         format_template,
         std::to_underlying(s),
         to_reason_phrase(s),
         std::chrono::floor<std::chrono::seconds>(std::chrono::system_clock::now()),
         cors_header,
         content_type,
-        body.size(),
-        body
+        content_length
     );
-    m_finalized = true;
 }
 
 inline void response::set_blob(std::string_view blob_data, std::string_view content_type, std::string_view content_disposition) {
     if (m_finalized) return;
+    write_blob_headers(content_type, content_disposition, blob_data.size());
+    m_body = std::string(blob_data);
+    m_finalized = true;
+}
+
+template<typename Blob> requires std::same_as<Blob, std::string>
+inline void response::set_blob(Blob&& blob_data, std::string_view content_type, std::string_view content_disposition) {
+    if (m_finalized) return;
+    write_blob_headers(content_type, content_disposition, blob_data.size());
+    m_body = std::move(blob_data);
+    m_finalized = true;
+}
+
+inline void response::write_blob_headers(std::string_view content_type, std::string_view content_disposition, size_t content_length) {
     constexpr std::string_view format_template =
         "HTTP/1.1 200 OK\r\n"
         "Date: {:%a, %d %b %Y %H:%M:%S GMT}\r\n"
@@ -127,16 +302,14 @@ inline void response::set_blob(std::string_view blob_data, std::string_view cont
         "\r\n";
     const auto cors_header = m_origin ? std::format("Access-Control-Allow-Origin: {}\r\nvary: Origin\r\n", *m_origin) : "";
     std::format_to(
-        std::back_inserter(m_buffer),
+        std::back_inserter(m_header),
         format_template,
         std::chrono::floor<std::chrono::seconds>(std::chrono::system_clock::now()),
         cors_header,
         content_type,
         content_disposition,
-        blob_data.size()
+        content_length
     );
-    m_buffer.insert(m_buffer.end(), blob_data.begin(), blob_data.end());
-    m_finalized = true;
 }
 
 inline void response::set_options() {
@@ -153,7 +326,7 @@ inline void response::set_options() {
         "\r\n";
     const auto cors_header = m_origin ? std::format("Access-Control-Allow-Origin: {}\r\n", *m_origin) : "";
     std::format_to(
-        std::back_inserter(m_buffer),
+        std::back_inserter(m_header),
         format_template,
         std::chrono::floor<std::chrono::seconds>(std::chrono::system_clock::now()),
         cors_header
@@ -161,15 +334,113 @@ inline void response::set_options() {
     m_finalized = true;
 }
 
-inline std::span<const char> response::buffer() const noexcept {
-    if (m_readPos >= m_buffer.size()) {
-        return {};
+inline void response::set_file(const std::string& path, std::string_view content_type, std::string_view content_disposition,
+                               std::optional<std::string_view> range, std::optional<std::string_view> if_modified_since) {
+    if (m_finalized) return;
+    file_body file(::open(path.c_str(), O_RDONLY | O_CLOEXEC), 0, 0);
+    struct stat st{};
+    if (file.fd() == -1 || fstat(file.fd(), &st) == -1 || !S_ISREG(st.st_mode)) {
+        set_body(status::not_found, R"({"error":"Not Found"})");
+        return;
+    }
+    const auto size = static_cast<size_t>(st.st_size);
+    const std::chrono::sys_seconds last_modified{std::chrono::seconds{st.st_mtim.tv_sec}};
+
+    if (const auto since = if_modified_since.and_then(detail::parse_http_date); since && last_modified <= *since) {
+        write_file_headers(status::not_modified, last_modified, "");
+        m_finalized = true;
+        return;
+    }
+
+    const auto byte_range = range.and_then([size](std::string_view r) { return detail::parse_byte_range(r, size); });
+    if (byte_range && !byte_range->satisfiable) {
+        write_file_headers(status::range_not_satisfiable, last_modified,
+            std::format("Content-Range: bytes */{}\r\nContent-Length: 0\r\n", size));
+        m_finalized = true;
+        return;
+    }
+
+    const size_t first = byte_range ? byte_range->first : 0;
+    const size_t length = byte_range ? byte_range->last - first + 1 : size;
+    const auto content_range = byte_range ? std::format("Content-Range: bytes {}-{}/{}\r\n", first, byte_range->last, size) : std::string{};
+    write_file_headers(byte_range ? status::partial_content : status::ok, last_modified,
+        std::format("{}Content-Type: {}\r\nContent-Disposition: {}\r\nContent-Length: {}\r\n",
+                    content_range, content_type, content_disposition, length));
+    m_body = file_body(file.release(), static_cast<off_t>(first), length);
+    m_finalized = true;
+}
+
+inline void response::write_file_headers(status s, std::chrono::sys_seconds last_modified, std::string_view entity_headers) {
+    m_status = s;
+    constexpr std::string_view format_template =
+        "HTTP/1.1 {} {}\r\n"
+        "Date: {:%a, %d %b %Y %H:%M:%S GMT}\r\n"
+        "{}"
+        "Access-Control-Expose-Headers: Content-Disposition\r\n"
+        "Strict-Transport-Security: max-age=31536000; includeSubDomains\r\n"
+        "Content-Security-Policy: default-src 'none'; frame-ancestors 'none'\r\n"
+        "X-Frame-Options: SAMEORIGIN\r\n"
+        "X-Content-Type-Options: nosniff\r\n"
+        "Referrer-Policy: no-referrer\r\n"
+        "Cache-Control: private, no-cache\r\n"
+        "Connection: keep-alive\r\n"
+        "Accept-Ranges: bytes\r\n"
+        "Last-Modified: {:%a, %d %b %Y %H:%M:%S GMT}\r\n"
+        "{}"
+        "\r\n";
+    const auto cors_header = m_origin ? std::format("Access-Control-Allow-Origin: {}\r\nvary: Origin\r\n", *m_origin) : "";
+    std::format_to(
+        std::back_inserter(m_header),
+        format_template,
+        std::to_underlying(s),
+        to_reason_phrase(s),
+        std::chrono::floor<std::chrono::seconds>(std::chrono::system_clock::now()),
+        cors_header,
+        last_modified,
+        entity_headers
+    );
+}
+
+inline std::string_view response::body() const noexcept {
+    if (const auto* shared = std::get_if<std::shared_ptr<const std::string>>(&m_body)) {
+        return **shared;
+    }
+    if (const auto* owned = std::get_if<std::string>(&m_body)) {
+        return *owned;
+    }
+    return {};
+}
+
+inline size_t response::body_size() const noexcept {
+    if (const auto* file = std::get_if<file_body>(&m_body)) {
+        return file->length();
+    }
+    return body().size();
+}
+
+inline bool response::has_file() const noexcept {
+    return std::holds_alternative<file_body>(m_body);
+}
+
+inline std::optional<file_chunk> response::pending_file() const noexcept {
+    const auto* file = std::get_if<file_body>(&m_body);
+    if (file == nullptr || m_readPos < m_header.size()) return std::nullopt;
+    const size_t sent = m_readPos - m_header.size();
+    if (sent >= file->length()) return std::nullopt;
+    return file_chunk{file->fd(), file->offset() + static_cast<off_t>(sent), file->length() - sent};
+}
+
+inline std::array<std::span<const char>, 2> response::buffers() const noexcept {
+    const std::span<const char> body_span{body()};
+    if (m_readPos < m_header.size()) {
+        return {std::span<const char>{m_header}.subspan(m_readPos), body_span};
     }
-    return {m_buffer.data() + m_readPos, available_size()};
+    return {std::span<const char>{}, body_span.subspan(std::min(m_readPos - m_header.size(), body_span.size()))};
 }
 
 inline size_t response::available_size() const noexcept {
-    return m_buffer.size() > m_readPos ? m_buffer.size() - m_readPos : 0;
+    const size_t total = m_header.size() + body_size();
+    return total > m_readPos ? total - m_readPos : 0;
 }
 
 inline void response::update_pos(size_t bytes_sent) noexcept {
@@ -0,0 +1,107 @@
+#ifndef INLINE_TASK_HPP
+#define INLINE_TASK_HPP
+
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+/**
+ * @brief Move-only void() callable stored inline, never on the heap.
+ *
+ * A replacement for std::function on the dispatch path: the callable (a lambda capturing the server
+ * and a pointer to the request's job) lives in a fixed buffer inside the task, so tasks can sit
+ * in a preallocated ring and moving one costs a small copy. Callables that do not fit fail to compile.
+ *
+ * @tparam Capacity Bytes of inline storage.
+ */
+template<size_t Capacity>
+class inline_task {
+public:
+    static constexpr size_t capacity = Capacity;
+
+    inline_task() noexcept = default;
+
+    // Implicit, like std::function, so lambdas convert at the call site
+    template<typename F>
+        requires (!std::same_as<std::remove_cvref_t<F>, inline_task> && std::invocable<std::decay_t<F>&>)
+    inline_task(F&& fn) { // NOSONAR: implicit conversion is intended
+        using callable = std::decay_t<F>;
+        static_assert(sizeof(callable) <= Capacity, "task captures exceed the inline storage");
+        static_assert(alignof(callable) <= alignof(std::max_align_t), "task captures are over-aligned");
+        static_assert(std::is_nothrow_move_constructible_v<callable>, "task captures must be nothrow movable");
+        ::new (static_cast<void*>(m_storage.data())) callable(std::forward<F>(fn));
+        m_ops = &ops_for<callable>;
+    }
+
+    inline_task(inline_task&& other) noexcept {
+        take(other);
+    }
+
+    inline_task& operator=(inline_task&& other) noexcept {
+        if (this != &other) {
+            reset();
+            take(other);
+        }
+        return *this;
+    }
+
+    inline_task(const inline_task&) = delete;
+    inline_task& operator=(const inline_task&) = delete;
+
+    ~inline_task() noexcept {
+        reset();
+    }
+
+    explicit operator bool() const noexcept {
+        return m_ops != nullptr;
+    }
+
+    void operator()() {
+        m_ops->invoke(m_storage.data());
+    }
+
+    void reset() noexcept {
+        if (m_ops != nullptr) {
+            m_ops->destroy(m_storage.data());
+            m_ops = nullptr;
+        }
+    }
+
+private:
+    struct operations {
+        void (*invoke)(std::byte*);
+        void (*relocate)(std::byte* to, std::byte* from) noexcept;
+        void (*destroy)(std::byte*) noexcept;
+    };
+
+    template<typename Callable>
+    static Callable* as(std::byte* storage) noexcept {
+        return std::launder(reinterpret_cast<Callable*>(storage)); // NOSONAR: type-erased storage
+    }
+
+    template<typename Callable>
+    static constexpr operations ops_for{
+        [](std::byte* s) { (*as<Callable>(s))(); },
+        [](std::byte* to, std::byte* from) noexcept {
+            ::new (static_cast<void*>(to)) Callable(std::move(*as<Callable>(from)));
+            as<Callable>(from)->~Callable();
+        },
+        [](std::byte* s) noexcept { as<Callable>(s)->~Callable(); }
+    };
+
+    // Leaves other empty
+    void take(inline_task& other) noexcept {
+        if (other.m_ops != nullptr) {
+            other.m_ops->relocate(m_storage.data(), other.m_storage.data());
+            m_ops = std::exchange(other.m_ops, nullptr);
+        }
+    }
+
+    alignas(std::max_align_t) std::array<std::byte, Capacity> m_storage;
+    const operations* m_ops{nullptr};
+};
+
+#endif // INLINE_TASK_HPP
@@ -0,0 +1,284 @@
+#ifndef IO_RING_HPP
+#define IO_RING_HPP
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <format>
+
+class io_ring_error : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+/**
+ * @brief Minimal single-threaded io_uring instance driven through the raw syscalls.
+ *
+ * Only what the reactor needs: SQE acquisition, submit-and-wait with an optional
+ * timeout, CQE iteration and provided-buffer ring registration. It must be created
+ * and used by the same thread (IORING_SETUP_SINGLE_ISSUER when the kernel has it).
+ */
+class io_ring {
+public:
+    explicit io_ring(unsigned entries) {
+        io_uring_params params{};
+        params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_DEFER_TASKRUN;
+        params.cq_entries = entries * 4;
+        m_fd = setup(entries, params);
+        if (m_fd == -EINVAL) {
+            // Pre-6.1 kernels: fall back to a plain ring
+            params = io_uring_params{};
+            params.flags = IORING_SETUP_CQSIZE;
+            params.cq_entries = entries * 4;
+            m_fd = setup(entries, params);
+        }
+        if (m_fd < 0) {
+            throw io_ring_error(std::format("io_uring_setup failed: {}", std::strerror(-m_fd)));
+        }
+        if ((params.features & IORING_FEAT_SINGLE_MMAP) == 0 || (params.features & IORING_FEAT_NODROP) == 0) {
+            close(m_fd);
+            throw io_ring_error("io_uring kernel support is too old (needs SINGLE_MMAP and NODROP)");
+        }
+        map_rings(params);
+    }
+
+    ~io_ring() noexcept {
+        if (m_sqes != nullptr) munmap(m_sqes, m_sqes_size);
+        if (m_ring_ptr != nullptr) munmap(m_ring_ptr, m_ring_size);
+        if (m_fd != -1) close(m_fd);
+    }
+
+    io_ring(const io_ring&) = delete;
+    io_ring& operator=(const io_ring&) = delete;
+    io_ring(io_ring&&) = delete;
+    io_ring& operator=(io_ring&&) = delete;
+
+    [[nodiscard]] int fd() const noexcept { return m_fd; }
+
+    // Returns a zeroed SQE, flushing the submission queue to the kernel first if it is full
+    [[nodiscard]] io_uring_sqe& get_sqe() {
+        if (m_sq_tail - load_acquire(m_sq_head) >= m_sq_entries) {
+            submit_and_wait(0);
+        }
+        io_uring_sqe& sqe = m_sqes[m_sq_tail & m_sq_mask];
+        std::memset(&sqe, 0, sizeof(sqe));
+        ++m_sq_tail;
+        return sqe;
+    }
+
+    // Flushes pending SQEs if fewer than count slots are free, so a linked chain is never split across submissions
+    void reserve(unsigned count) {
+        if (m_sq_entries - (m_sq_tail - load_acquire(m_sq_head)) < count) {
+            submit_and_wait(0);
+        }
+    }
+
+    /**
+     * @brief Publishes queued SQEs and optionally blocks for completions.
+     * @return Number of SQEs consumed, or a negative errno (-EINTR, -ETIME and -EBUSY are benign).
+     */
+    int submit_and_wait(unsigned wait_nr, const __kernel_timespec* timeout = nullptr) {
+        store_release(m_sq_ktail, m_sq_tail);
+        const unsigned to_submit = m_sq_tail - load_acquire(m_sq_head);
+
+        unsigned flags = wait_nr > 0 || m_defer_taskrun ? IORING_ENTER_GETEVENTS : 0;
+        const void* arg = nullptr;
+        size_t arg_size = 0;
+        io_uring_getevents_arg ext{};
+        if (timeout != nullptr) {
+            ext.ts = reinterpret_cast<uint64_t>(timeout); // NOSONAR: kernel ABI takes the pointer as u64
+            flags |= IORING_ENTER_EXT_ARG;
+            arg = &ext;
+            arg_size = sizeof(ext);
+        }
+        const auto rc = syscall(__NR_io_uring_enter, m_fd, to_submit, wait_nr, flags, arg, arg_size);
+        return rc < 0 ? -errno : static_cast<int>(rc);
+    }
+
+    // Invokes fn(const io_uring_cqe&) for every available completion and releases them
+    template<typename Fn>
+    unsigned for_each_cqe(Fn&& fn) {
+        unsigned head = *m_cq_khead;
+        const unsigned tail = load_acquire(m_cq_ktail);
+        const unsigned count = tail - head;
+        for (; head != tail; ++head) {
+            fn(static_cast<const io_uring_cqe&>(m_cqes[head & m_cq_mask]));
+        }
+        store_release(m_cq_khead, head);
+        return count;
+    }
+
+    void register_buffer_ring(void* ring_addr, unsigned entries, uint16_t group_id) const {
+        io_uring_buf_reg reg{};
+        reg.ring_addr = reinterpret_cast<uint64_t>(ring_addr); // NOSONAR: kernel ABI takes the pointer as u64
+        reg.ring_entries = entries;
+        reg.bgid = group_id;
+        if (syscall(__NR_io_uring_register, m_fd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+            throw io_ring_error(std::format("IORING_REGISTER_PBUF_RING failed: {}", std::strerror(errno)));
+        }
+    }
+
+private:
+    static int setup(unsigned entries, io_uring_params& params) {
+        const auto rc = syscall(__NR_io_uring_setup, entries, &params);
+        return rc < 0 ? -errno : static_cast<int>(rc);
+    }
+
+    static unsigned load_acquire(unsigned* p) noexcept {
+        return std::atomic_ref<unsigned>(*p).load(std::memory_order_acquire);
+    }
+
+    static void store_release(unsigned* p, unsigned v) noexcept {
+        std::atomic_ref<unsigned>(*p).store(v, std::memory_order_release);
+    }
+
+    void map_rings(const io_uring_params& params) {
+        m_defer_taskrun = (params.flags & IORING_SETUP_DEFER_TASKRUN) != 0;
+
+        // SINGLE_MMAP: the SQ and CQ rings share one mapping
+        m_ring_size = std::max(params.sq_off.array + params.sq_entries * sizeof(unsigned),
+                               params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+        void* ring = mmap(nullptr, m_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQ_RING);
+        if (ring == MAP_FAILED) {
+            close(m_fd);
+            throw io_ring_error(std::format("io_uring ring mmap failed: {}", std::strerror(errno)));
+        }
+        m_ring_ptr = ring;
+
+        m_sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+        void* sqes = mmap(nullptr, m_sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQES);
+        if (sqes == MAP_FAILED) {
+            munmap(m_ring_ptr, m_ring_size);
+            close(m_fd);
+            throw io_ring_error(std::format("io_uring SQE mmap failed: {}", std::strerror(errno)));
+        }
+        m_sqes = static_cast<io_uring_sqe*>(sqes);
+
+        auto* base = static_cast<char*>(m_ring_ptr);
+        m_sq_head = reinterpret_cast<unsigned*>(base + params.sq_off.head);
+        m_sq_ktail = reinterpret_cast<unsigned*>(base + params.sq_off.tail);
+        m_sq_mask = *reinterpret_cast<unsigned*>(base + params.sq_off.ring_mask);
+        m_sq_entries = params.sq_entries;
+        m_cq_khead = reinterpret_cast<unsigned*>(base + params.cq_off.head);
+        m_cq_ktail = reinterpret_cast<unsigned*>(base + params.cq_off.tail);
+        m_cq_mask = *reinterpret_cast<unsigned*>(base + params.cq_off.ring_mask);
+        m_cqes = reinterpret_cast<io_uring_cqe*>(base + params.cq_off.cqes);
+
+        // Identity-map the SQ index array once; SQEs are always consumed in order
+        auto* array = reinterpret_cast<unsigned*>(base + params.sq_off.array);
+        for (unsigned i = 0; i < m_sq_entries; ++i) {
+            array[i] = i;
+        }
+        m_sq_tail = *m_sq_ktail;
+    }
+
+    int m_fd{-1};
+    void* m_ring_ptr{nullptr};
+    size_t m_ring_size{0};
+    io_uring_sqe* m_sqes{nullptr};
+    size_t m_sqes_size{0};
+
+    unsigned* m_sq_head{nullptr};
+    unsigned* m_sq_ktail{nullptr};
+    unsigned m_sq_mask{0};
+    unsigned m_sq_entries{0};
+    unsigned m_sq_tail{0};
+
+    unsigned* m_cq_khead{nullptr};
+    unsigned* m_cq_ktail{nullptr};
+    unsigned m_cq_mask{0};
+    io_uring_cqe* m_cqes{nullptr};
+    bool m_defer_taskrun{false};
+};
+
+/**
+ * @brief Kernel-selected receive buffers (IORING_REGISTER_PBUF_RING) for multishot recv.
+ *
+ * The kernel picks a free buffer for each completion and reports its id in the CQE
+ * flags; the reactor copies the bytes out and hands the buffer straight back.
+ */
+class provided_buffer_ring {
+public:
+    provided_buffer_ring(const io_ring& ring, uint16_t group_id, uint16_t count, uint32_t buffer_size)
+        : m_group_id(group_id), m_count(count), m_buffer_size(buffer_size) {
+        if (count == 0 || (count & (count - 1)) != 0) {
+            throw io_ring_error("provided buffer count must be a power of two");
+        }
+        m_ring_size = count * sizeof(io_uring_buf);
+        void* mem = mmap(nullptr, m_ring_size + count * static_cast<size_t>(buffer_size),
+                         PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mem == MAP_FAILED) {
+            throw io_ring_error(std::format("provided buffer mmap failed: {}", std::strerror(errno)));
+        }
+        // Indexed as a plain io_uring_buf array: in C++ the header's __DECLARE_FLEX_ARRAY
+        // wrapper adds a byte and would shift bufs[] off the kernel layout
+        m_ring = static_cast<io_uring_buf*>(mem);
+        m_buffers = static_cast<char*>(mem) + m_ring_size;
+
+        for (uint16_t bid = 0; bid < count; ++bid) {
+            put(bid);
+        }
+        publish();
+        try {
+            ring.register_buffer_ring(m_ring, count, group_id);
+        } catch (const io_ring_error&) {
+            munmap(m_ring, m_ring_size + m_count * static_cast<size_t>(m_buffer_size));
+            throw;
+        }
+    }
+
+    ~provided_buffer_ring() noexcept {
+        // The kernel drops its reference when the owning ring is closed
+        munmap(m_ring, m_ring_size + m_count * static_cast<size_t>(m_buffer_size));
+    }
+
+    provided_buffer_ring(const provided_buffer_ring&) = delete;
+    provided_buffer_ring& operator=(const provided_buffer_ring&) = delete;
+    provided_buffer_ring(provided_buffer_ring&&) = delete;
+    provided_buffer_ring& operator=(provided_buffer_ring&&) = delete;
+
+    [[nodiscard]] uint16_t group_id() const noexcept { return m_group_id; }
+
+    [[nodiscard]] std::string_view view(uint16_t bid, size_t len) const noexcept {
+        return {m_buffers + static_cast<size_t>(bid) * m_buffer_size, std::min<size_t>(len, m_buffer_size)};
+    }
+
+    // Returns a buffer to the kernel
+    void recycle(uint16_t bid) noexcept {
+        put(bid);
+        publish();
+    }
+
+private:
+    void put(uint16_t bid) noexcept {
+        io_uring_buf& buf = m_ring[m_tail & (m_count - 1)];
+        buf.addr = reinterpret_cast<uint64_t>(m_buffers + static_cast<size_t>(bid) * m_buffer_size); // NOSONAR: kernel ABI
+        buf.len = m_buffer_size;
+        buf.bid = bid;
+        ++m_tail;
+    }
+
+    void publish() noexcept {
+        // The ring tail overlays the resv field of the first entry
+        std::atomic_ref<uint16_t>(m_ring[0].resv).store(m_tail, std::memory_order_release);
+    }
+
+    io_uring_buf* m_ring{nullptr};
+    char* m_buffers{nullptr};
+    size_t m_ring_size{0};
+    uint16_t m_group_id;
+    uint16_t m_count;
+    uint32_t m_buffer_size;
+    uint16_t m_tail{0};
+};
+
+#endif // IO_RING_HPP
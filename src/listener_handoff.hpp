@@ -0,0 +1,209 @@
+#ifndef LISTENER_HANDOFF_HPP
+#define LISTENER_HANDOFF_HPP
+
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <format>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+extern char** environ; // NOSONAR: POSIX global, passed on to the new binary
+
+/**
+ * @brief Hands the listening sockets of a running server to a freshly exec'd binary.
+ *
+ * The running process forks and execs the binary with a clean descriptor table plus one end of a Unix
+ * socket pair at fd 3, announced by UPGRADE_SOCKET_FD. It sends its listening fds over that socket
+ * (SCM_RIGHTS) and waits for a ready byte. Both processes then hold the same kernel sockets, so the
+ * accept queues and SO_REUSEPORT group survive and no SYN is dropped while the old process drains.
+ */
+namespace handoff {
+
+    class handoff_error : public std::runtime_error {
+    public:
+        using std::runtime_error::runtime_error;
+    };
+
+    inline constexpr const char* SOCKET_ENV{"UPGRADE_SOCKET_FD"};
+    inline constexpr int CHILD_FD{3};
+    inline constexpr char READY{'R'};
+    inline constexpr std::string_view MAGIC{"apiserver2-listeners"};
+    inline constexpr size_t MAX_FDS{253}; // SCM_MAX_FD
+
+    struct successor {
+        pid_t pid{-1};
+        int channel{-1};
+    };
+
+    // Path of the running binary, resolved at startup so a binary replaced on disk is picked up on upgrade
+    [[nodiscard]] inline std::string current_executable() {
+        std::array<char, 4096> path{};
+        const ssize_t n = readlink("/proc/self/exe", path.data(), path.size() - 1);
+        return n > 0 ? std::string(path.data(), static_cast<size_t>(n)) : std::string{};
+    }
+
+    /**
+     * @brief Starts binary as a new process holding one end of a socket pair at CHILD_FD.
+     * @details Only async-signal-safe calls run between fork and exec; the environment is prepared before.
+     * @throws handoff_error if the socket pair or the fork fails. A failing exec ends the child with 127.
+     */
+    [[nodiscard]] inline successor spawn(const std::string& binary) {
+        std::array<int, 2> pair{};
+        if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, pair.data()) == -1) {
+            throw handoff_error(std::format("socketpair failed: {}", std::strerror(errno)));
+        }
+
+        std::vector<std::string> env_storage;
+        for (char** e = environ; *e != nullptr; ++e) {
+            if (!std::string_view(*e).starts_with(SOCKET_ENV)) env_storage.emplace_back(*e);
+        }
+        env_storage.push_back(std::format("{}={}", SOCKET_ENV, CHILD_FD));
+        std::vector<char*> envp;
+        for (auto& entry : env_storage) envp.push_back(entry.data());
+        envp.push_back(nullptr);
+        std::string arg0 = binary;
+        std::array<char*, 2> argv{arg0.data(), nullptr};
+
+        const pid_t pid = fork();
+        if (pid == -1) {
+            const int err = errno;
+            close(pair[0]);
+            close(pair[1]);
+            throw handoff_error(std::format("fork failed: {}", std::strerror(err)));
+        }
+        if (pid == 0) {
+            // Child: only the channel survives; connections and reactor fds must not leak into the new binary
+            if (pair[1] == CHILD_FD) {
+                fcntl(CHILD_FD, F_SETFD, 0);
+            } else {
+                dup2(pair[1], CHILD_FD);
+            }
+            syscall(SYS_close_range, CHILD_FD + 1, ~0U, 0);
+            sigset_t none;
+            sigemptyset(&none);
+            sigprocmask(SIG_SETMASK, &none, nullptr);
+            execve(binary.c_str(), argv.data(), envp.data());
+            _exit(127);
+        }
+        close(pair[1]);
+        return {pid, pair[0]};
+    }
+
+    // Sends the listening fds, in reuseport group order, in a single message
+    inline void send_fds(int channel, std::span<const int> fds) {
+        if (fds.empty() || fds.size() > MAX_FDS) {
+            throw handoff_error(std::format("cannot hand over {} listening sockets", fds.size()));
+        }
+        std::vector<char> control(CMSG_SPACE(sizeof(int) * fds.size()));
+        iovec iov{const_cast<char*>(MAGIC.data()), MAGIC.size()}; // NOSONAR: sendmsg takes non-const iov_base
+        msghdr msg{};
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control.data();
+        msg.msg_controllen = control.size();
+        cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int) * fds.size());
+        std::memcpy(CMSG_DATA(cmsg), fds.data(), sizeof(int) * fds.size());
+        if (sendmsg(channel, &msg, MSG_NOSIGNAL) == -1) {
+            throw handoff_error(std::format("sendmsg failed: {}", std::strerror(errno)));
+        }
+    }
+
+    // Receives the fds sent by send_fds(), marked close-on-exec
+    [[nodiscard]] inline std::vector<int> receive_fds(int channel) {
+        std::array<char, 64> payload{};
+        std::vector<char> control(CMSG_SPACE(sizeof(int) * MAX_FDS));
+        iovec iov{payload.data(), payload.size()};
+        msghdr msg{};
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control.data();
+        msg.msg_controllen = control.size();
+
+        ssize_t n = -1;
+        do {
+            n = recvmsg(channel, &msg, MSG_CMSG_CLOEXEC);
+        } while (n == -1 && errno == EINTR);
+        if (n == -1) {
+            throw handoff_error(std::format("recvmsg failed: {}", std::strerror(errno)));
+        }
+
+        std::vector<int> fds;
+        for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) continue;
+            const size_t count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            const size_t first = fds.size();
+            fds.resize(first + count);
+            std::memcpy(fds.data() + first, CMSG_DATA(cmsg), sizeof(int) * count);
+        }
+        if (std::string_view(payload.data(), static_cast<size_t>(n)) != MAGIC || (msg.msg_flags & MSG_CTRUNC) != 0) {
+            for (const int fd : fds) close(fd);
+            throw handoff_error("unexpected handoff message");
+        }
+        return fds;
+    }
+
+    // Waits for the successor's ready byte; false on timeout, or if it exited or closed the channel
+    [[nodiscard]] inline bool wait_ready(int channel, std::chrono::milliseconds timeout) {
+        pollfd pfd{channel, POLLIN, 0};
+        int rc = -1;
+        do {
+            rc = poll(&pfd, 1, static_cast<int>(timeout.count()));
+        } while (rc == -1 && errno == EINTR);
+        char byte = 0;
+        return rc == 1 && read(channel, &byte, 1) == 1 && byte == READY;
+    }
+
+    inline void signal_ready(int channel) noexcept {
+        [[maybe_unused]] const ssize_t n = send(channel, &READY, 1, MSG_NOSIGNAL);
+    }
+
+    // Stops a successor that failed to take over; reaps it so no zombie is left
+    inline void abandon(const successor& next) noexcept {
+        if (next.channel != -1) close(next.channel);
+        if (next.pid > 0) {
+            kill(next.pid, SIGKILL);
+            waitpid(next.pid, nullptr, 0);
+        }
+    }
+
+    /**
+     * @brief Sends a state string to systemd's notify socket (sd_notify protocol), if NOTIFY_SOCKET is set.
+     * @details Lets a successor announce itself with "MAINPID=<pid>" so the unit survives the old process exit.
+     */
+    inline void notify_service_manager(std::string_view state) noexcept {
+        const char* path = std::getenv("NOTIFY_SOCKET");
+        if (path == nullptr || path[0] == '\0') return;
+        const std::string_view socket_path(path);
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        if (socket_path.size() >= sizeof(addr.sun_path)) return;
+        std::memcpy(addr.sun_path, socket_path.data(), socket_path.size());
+        if (addr.sun_path[0] == '@') addr.sun_path[0] = '\0'; // abstract namespace
+        const auto len = static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + socket_path.size());
+
+        const int fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+        if (fd == -1) return;
+        [[maybe_unused]] const ssize_t n = sendto(fd, state.data(), state.size(), MSG_NOSIGNAL, reinterpret_cast<const sockaddr*>(&addr), len); // NOSONAR: sockaddr cast required by the API
+        close(fd);
+    }
+}
+
+#endif // LISTENER_HANDOFF_HPP
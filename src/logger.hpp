@@ -9,6 +9,7 @@
 #include <thread>
 #include <string>
 #include <cstdio> // For stdout, stderr
+#include "text_scan.hpp"
 
 #ifdef USE_STACKTRACE
 #include <stacktrace>
@@ -57,24 +58,7 @@ namespace detail {
         constexpr size_t RESERVE_PADDING = 10; // Avoid magic number for SonarCloud
         std::string res;
         res.reserve(s.size() + RESERVE_PADDING);
-        
-        for (char c : s) {
-            switch (c) {
-                case '"': res += R"(\")"; break;
-                case '\\': res += R"(\\)"; break;
-                case '\b': res += R"(\b)"; break;
-                case '\f': res += R"(\f)"; break;
-                case '\n': res += R"(\n)"; break;
-                case '\r': res += R"(\r)"; break;
-                case '\t': res += R"(\t)"; break;
-                default:
-                    if (static_cast<unsigned char>(c) < 0x20) {
-                        res += std::format("\\u{:04x}", static_cast<unsigned char>(c));
-                    } else {
-                        res += c;
-                    }
-            }
-        }
+        util::text::append_json_escaped(res, s);
         return res;
     }
 
@@ -162,6 +146,11 @@ public:
     request_id_scope& operator=(request_id_scope&&) = delete;
 };
 
+// The request ID set on this thread, empty outside a request_id_scope
+[[nodiscard]] inline std::string_view current_request_id() noexcept {
+    return detail::g_request_id;
+}
+
 // --- Public API ---
 
 template<typename... Args>
@@ -2,6 +2,7 @@
 #include "logger.hpp"
 #include "webapi_path.hpp"
 #include "sql.hpp"
+#include "async_sql.hpp" // for coroutine handlers
 #include "input_validator.hpp"
 #include "util.hpp"
 #include "json_parser.hpp"
@@ -80,6 +81,14 @@ const validator upload_validator {
     rule<std::string>{"title", requirement::required}
 };
 
+// a file name saved by /upload: uuid plus extension, no path components
+const validator download_validator {
+    rule<std::string>{"name", requirement::required, [](std::string_view s) {
+        return !s.empty() && s.size() <= 64 && !s.starts_with('.')
+            && std::ranges::all_of(s, [](unsigned char c) { return std::isalnum(c) || c == '-' || c == '.'; });
+    }, "Name must be a file name returned by /upload."}
+};
+
 // validator for /customers endpoint: filter is optional, max 10 chars
 const validator customers_validator {
     rule<std::string>{"filter", requirement::optional,
@@ -129,12 +138,13 @@ void get_nonce([[maybe_unused]] const http::request& req, http::response& res) {
     res.set_body(ok, std::format(R"({{"nonce":"{}"}})", jwt::get_nonce()));
 }
 
-void get_shippers([[maybe_unused]] const http::request& req, http::response& res) {
-    res.set_body(ok, sql::get("DB1", "{CALL sp_shippers_view}").value_or("[]"));
+// Coroutine handlers: the worker thread is released while the query runs on the blocking pool
+async::task<void> get_shippers([[maybe_unused]] const http::request& req, http::response& res) {
+    res.set_body(ok, (co_await async::sql::get("DB1", "{CALL sp_shippers_view}")).value_or("[]"));
 }
 
-void get_products([[maybe_unused]] const http::request& req, http::response& res) {
-    res.set_body(ok, sql::get("DB1", "{CALL sp_products_view}").value_or("[]"));
+async::task<void> get_products([[maybe_unused]] const http::request& req, http::response& res) {
+    res.set_body(ok, (co_await async::sql::get("DB1", "{CALL sp_products_view}")).value_or("[]"));
 }
 
 void get_customer(const http::request& req, http::response& res) {
@@ -296,6 +306,34 @@ void upload_file(const http::request& req, http::response& res) {
     }
 }
 
+std::string_view blob_content_type(const std::filesystem::path& extension) {
+    static const std::map<std::string, std::string_view, std::less<>> types {
+        {".pdf", "application/pdf"}, {".png", "image/png"}, {".jpg", "image/jpeg"}, {".jpeg", "image/jpeg"},
+        {".gif", "image/gif"}, {".webp", "image/webp"}, {".svg", "image/svg+xml"}, {".txt", "text/plain"},
+        {".csv", "text/csv"}, {".json", "application/json"}, {".zip", "application/zip"}
+    };
+    std::string ext = extension.string();
+    std::ranges::transform(ext, ext.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    if (auto it = types.find(ext); it != types.end()) {
+        return it->second;
+    }
+    return "application/octet-stream";
+}
+
+// serves a file saved by /upload straight from disk (sendfile), honouring Range and If-Modified-Since
+void download_file(const http::request& req, http::response& res) {
+    const auto blob_path_str = env::get<std::string>("BLOB_PATH", "");
+    if (blob_path_str.empty()) {
+        util::log::error("BLOB_PATH environment variable is not set.");
+        res.set_body(internal_server_error, R"({"error":"File download is not configured on the server."})");
+        return;
+    }
+    const auto name = req.get_required_param<std::string>("name");
+    const std::filesystem::path file_path = std::filesystem::path(blob_path_str) / name;
+    res.set_file(file_path.string(), blob_content_type(file_path.extension()), std::format(R"(inline; filename="{}")", name),
+                 req.get_header_value(http::header_id::range), req.get_header_value(http::header_id::if_modified_since));
+}
+
 //invokes remote REST API to get customer info
 void get_remote_customer(const http::request& req, http::response& res) {
     const auto customer_id = req.get_required_param<std::string>("id");
@@ -565,16 +603,21 @@ int main() {
         util::log::debug("Application starting...");
 
         server s;
+
+        // Bulkheads: password hashing and reports get their own workers, so a burst on them cannot starve the rest
+        s.add_worker_pool("auth", env::get<int>("AUTH_POOL_SIZE", 4));
+        s.add_worker_pool("reports", env::get<int>("REPORTS_POOL_SIZE", 4));
         
         //register API handlers
-        s.register_api(webapi_path{"/hello"}, get, &hello_world, false);
-        s.register_api(webapi_path{"/nonce"}, get, &get_nonce, false);
-        s.register_api(webapi_path{"/login"}, post, login_validator, &login, false);
-        s.register_api(webapi_path{"/shippers"}, get, &get_shippers, true);
-        s.register_api(webapi_path{"/products"}, get, &get_products, true);
-        s.register_api(webapi_path{"/customer"}, post, customer_validator, &get_customer, true);
-        s.register_api(webapi_path{"/sales"}, post, sales_validator, &get_sales_by_category, true);
+        s.register_api(webapi_path{"/hello"}, get, &hello_world, false, execution::io_thread);
+        s.register_api(webapi_path{"/nonce"}, get, &get_nonce, false, execution::io_thread);
+        s.register_api(webapi_path{"/login"}, post, login_validator, &login, false, worker_lane{.pool = "auth"});
+        s.register_api(webapi_path{"/shippers"}, get, &get_shippers, true, worker_lane{.prio = thread_pool::priority::high});
+        s.register_api(webapi_path{"/products"}, get, &get_products, true, worker_lane{.prio = thread_pool::priority::high});
+        s.register_api(webapi_path{"/customer"}, post, customer_validator, &get_customer, true, worker_lane{.prio = thread_pool::priority::high});
+        s.register_api(webapi_path{"/sales"}, post, sales_validator, &get_sales_by_category, true, worker_lane{.pool = "reports"});
         s.register_api(webapi_path{"/upload"}, post, upload_validator, &upload_file, true);
+        s.register_api(webapi_path{"/download/{name}"}, get, download_validator, &download_file, true);
         s.register_api(webapi_path{"/rcustomer"}, post, customer_validator, &get_remote_customer, true);
         s.register_api(webapi_path{"/mfa/qrcode"}, get, &get_mfa_qrcode, true);
         s.register_api(webapi_path{"/mfa/testotp"}, post, totp_validator, &test_mfa_otp, true);
@@ -584,7 +627,7 @@ int main() {
         s.register_api(webapi_path{"/webauthn/login"}, post, &webauthn_login, false);
         s.register_api(webapi_path{"/recaptcha"}, post, recaptcha_validator, &verify_recaptcha, false);
         s.register_api(webapi_path{"/nested"}, post, nested_validator, &handle_nested, false);
-        s.register_api(webapi_path{"/gethash"}, post, gethash_validator, &get_hash, false);
+        s.register_api(webapi_path{"/gethash"}, post, gethash_validator, &get_hash, false, worker_lane{.pool = "auth"});
         
         s.start();
 
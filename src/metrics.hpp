@@ -12,6 +12,8 @@
 
 #include "util.hpp"
 #include "thread_pool.hpp"
+#include "concurrency_limiter.hpp"
+#include "handler_usage.hpp"
 #include "logger.hpp"
 #include "env.hpp"
 
@@ -24,6 +26,9 @@
 #include <format>
 #include <mutex>
 #include <functional>
+#include <array>
+#include <algorithm>
+#include <cmath>
 
 /**
  * @class metrics
@@ -35,7 +40,12 @@
  * - Total processing time
  * - Active TCP connections
  * - Active worker threads
- * - Pending tasks in registered thread pools
+ * - Requests that expired while queued
+ * - Recent request latency, which with the above feeds the load balancer weight (load())
+ * - Pending tasks in registered thread pools, and tasks stolen between them
+ * - Threads, busy threads, queued and rejected tasks per worker pool
+ * - Adaptive concurrency limits, in-flight and shed requests per endpoint
+ * - Wall time, CPU time and context switches of the handler per endpoint
  * - System memory usage
  *
  * It provides methods to export this data for monitoring purposes.
@@ -80,6 +90,12 @@ public:
      * @note Uses std::memory_order_relaxed for minimal overhead.
      */
     void decrement_active_threads() noexcept { m_active_threads.fetch_sub(1, /* NOSONAR */ std::memory_order_relaxed); }
+
+    /**
+     * @brief Counts a request dropped because its deadline passed while it was queued.
+     * @note Uses std::memory_order_relaxed for minimal overhead.
+     */
+    void increment_expired_requests() noexcept { m_expired_requests.fetch_add(1, /* NOSONAR */ std::memory_order_relaxed); }
     
     /**
      * @brief Records the duration of a processed request.
@@ -90,8 +106,16 @@ public:
     void record_request_time(std::chrono::microseconds duration) noexcept {
         m_total_requests.fetch_add(1, /* NOSONAR */ std::memory_order_relaxed);
         m_total_processing_time_us.fetch_add(duration.count(), /* NOSONAR */ std::memory_order_relaxed);
+        // Recent latency, weighting each sample 1/8; a sample lost to a concurrent update does not move an average
+        const long long recent = m_recent_latency_us.load(/* NOSONAR */ std::memory_order_relaxed);
+        m_recent_latency_us.store(recent + (duration.count() - recent) / 8, /* NOSONAR */ std::memory_order_relaxed);
     }
 
+    /**
+     * @brief Marks the instance as shutting down, so load() asks the load balancer to drain it.
+     */
+    void set_draining() noexcept { m_draining.store(true, /* NOSONAR */ std::memory_order_relaxed); }
+
     /**
      * @brief Registers a thread pool for monitoring.
      * * The metrics collector will poll registered pools for pending task counts
@@ -104,6 +128,26 @@ public:
         m_thread_pools.push_back(pool);
     }
 
+    /**
+     * @brief Registers an endpoint's concurrency limiter for monitoring.
+     * @param path The endpoint path, used as label.
+     * @param limiter The limiter shared with the endpoint.
+     */
+    void register_limiter(std::string_view path, std::shared_ptr<const concurrency_limiter> limiter) {
+        std::scoped_lock lock(m_limiters_mutex);
+        m_limiters.emplace_back(std::string(path), std::move(limiter));
+    }
+
+    /**
+     * @brief Registers an endpoint's handler CPU-time totals for monitoring.
+     * @param path The endpoint path, used as label.
+     * @param usage The totals shared with the endpoint.
+     */
+    void register_usage(std::string_view path, std::shared_ptr<const handler_usage::endpoint_usage> usage) {
+        std::scoped_lock lock(m_usage_mutex);
+        m_usage.emplace_back(std::string(path), std::move(usage));
+    }
+
     /**
      * @brief Generates a JSON representation of the current metrics.
      * * Captures a consistent snapshot of the metrics and formats them into a JSON string.
@@ -120,17 +164,41 @@ public:
             "current_connections": {},
             "current_active_threads": {},
             "pending_tasks": {},
+            "stolen_tasks": {},
+            "expired_requests": {},
             "thread_pool_size": {},
             "total_ram_kb": {},
             "memory_usage_kb": {},
-            "memory_usage_percentage": {:.2f}
+            "memory_usage_percentage": {:.2f},
+            "concurrency_limits": [{}],
+            "worker_pools": [{}],
+            "handler_usage": [{}]
             }})";
+
+        std::string limits;
+        for (const auto& l : s.limits) {
+            limits += std::format(R"({}{{"path":"{}","limit":{},"inflight":{},"rejected":{}}})", 
+                                  limits.empty() ? "" : ",", l.path, l.limit, l.inflight, l.rejected);
+        }
+        std::string pools;
+        for (const auto& p : s.pools) {
+            pools += std::format(R"({}{{"pool":"{}","threads":{},"min_threads":{},"max_threads":{},"busy_threads":{},"pending_tasks":[{},{},{}],"queue_capacity":{},"rejected":{},"grown":{},"shrunk":{}}})", 
+                                 pools.empty() ? "" : ",", p.name, p.threads, p.min_threads, p.max_threads, p.busy, 
+                                 p.pending[0], p.pending[1], p.pending[2], p.capacity, p.rejected, p.grown, p.shrunk);
+        }
+        // cpu_ratio near 1: the endpoint computes; near 0: it waits
+        std::string usage;
+        for (const auto& u : s.usage) {
+            usage += std::format(R"({}{{"path":"{}","requests":{},"wall_seconds":{:.6f},"cpu_seconds":{:.6f},"cpu_ratio":{:.3f},"voluntary_switches":{},"involuntary_switches":{}}})",
+                                 usage.empty() ? "" : ",", u.path, u.requests, u.wall_s, u.cpu_s, 
+                                 u.wall_s > 0 ? u.cpu_s / u.wall_s : 0.0, u.voluntary, u.involuntary);
+        }
         
         return std::format(
             json_tpl,
             s.pod_name, s.start_time, s.total_reqs, s.avg_time_s, 
             s.current_connections, s.active_threads, s.pending_tasks, 
-            s.pool_size, s.total_ram_kb, s.memory_usage_kb, s.memory_usage_pct
+            s.stolen_tasks, s.expired_requests, s.pool_size, s.total_ram_kb, s.memory_usage_kb, s.memory_usage_pct, limits, pools, usage
         );
     }
 
@@ -166,6 +234,12 @@ public:
             "# HELP thread_pool_pending_tasks Number of tasks waiting in the queue\n"
             "# TYPE thread_pool_pending_tasks gauge\n"
             "thread_pool_pending_tasks{{pod=\"{}\"}} {}\n\n"
+            "# HELP thread_pool_stolen_tasks_total Tasks run by a worker pool other than the one they were queued on\n"
+            "# TYPE thread_pool_stolen_tasks_total counter\n"
+            "thread_pool_stolen_tasks_total{{pod=\"{}\"}} {}\n\n"
+            "# HELP http_requests_expired_total Requests dropped because their deadline passed while queued\n"
+            "# TYPE http_requests_expired_total counter\n"
+            "http_requests_expired_total{{pod=\"{}\"}} {}\n\n"
             "# HELP thread_pool_capacity Total number of threads in the pool\n"
             "# TYPE thread_pool_capacity gauge\n"
             "thread_pool_capacity{{pod=\"{}\"}} {}\n\n"
@@ -179,7 +253,7 @@ public:
             "# TYPE system_memory_usage_percent gauge\n"
             "system_memory_usage_percent{{pod=\"{}\"}} {:.2f}\n";
 
-        return std::format(
+        std::string out = std::format(
             prom_tpl,
             s.pod_name, s.start_time,
             s.pod_name, s.total_reqs,
@@ -188,11 +262,78 @@ public:
             s.pod_name, s.current_connections,
             s.pod_name, s.active_threads,
             s.pod_name, s.pending_tasks,
+            s.pod_name, s.stolen_tasks,
+            s.pod_name, s.expired_requests,
             s.pod_name, s.pool_size,
             s.pod_name, s.memory_usage_kb,
             s.pod_name, s.total_ram_kb,
             s.pod_name, s.memory_usage_pct
         );
+        if (!s.limits.empty()) {
+            append_limit_metrics(out, s);
+        }
+        append_pool_metrics(out, s);
+        if (!s.usage.empty()) {
+            append_usage_metrics(out, s);
+        }
+        return out;
+    }
+
+    /**
+     * @brief The instance's load as a load balancer should weigh it.
+     */
+    struct load_report {
+        unsigned weight{0};     // 1 to 100 relative to an idle instance; 0 when draining
+        bool drain{false};      // send no new traffic
+        double queue_fill{0};   // the fullest worker queue, 0 to 1
+        double busy_ratio{0};   // busy worker threads over the most the pools may run
+        int connections{0};
+        double latency_ms{0};   // recent average handler time
+    };
+
+    /**
+     * @brief Turns live load signals into a load balancer weight.
+     * @details Each signal becomes a pressure where 1 means saturated: queue fill over READY_QUEUE_LIMIT percent
+     * (default 80), recent latency over READY_LATENCY_MS and connections over READY_MAX_CONNECTIONS (both off
+     * by default), and busy threads at half weight, since pools with empty queues are still keeping up.
+     * The weight falls as the highest pressure rises; at 1, or while shutting down, the instance asks to be drained.
+     * @return load_report The weight and the signals behind it.
+     */
+    [[nodiscard]] load_report load() const {
+        struct thresholds {
+            double queue_limit{std::clamp(env::get<int>("READY_QUEUE_LIMIT", 80), 1, 100) / 100.0};
+            double latency_ms{static_cast<double>(std::max(0, env::get<int>("READY_LATENCY_MS", 0)))};
+            double max_connections{static_cast<double>(std::max(0, env::get<int>("READY_MAX_CONNECTIONS", 0)))};
+        };
+        static const thresholds limits;
+
+        load_report r;
+        r.connections = m_connections.load(/* NOSONAR */ std::memory_order_relaxed);
+        r.latency_ms = static_cast<double>(m_recent_latency_us.load(/* NOSONAR */ std::memory_order_relaxed)) / 1000.0;
+        size_t busy = 0;
+        size_t max_threads = 0;
+        {
+            std::scoped_lock lock(m_pools_mutex);
+            for (const auto& pool : m_thread_pools) {
+                busy += pool.get().get_busy_threads();
+                max_threads += pool.get().get_max_threads();
+                // Per pool, not summed: the fullest one starts rejecting first
+                const auto pending = static_cast<double>(pool.get().get_total_pending_tasks());
+                r.queue_fill = std::max(r.queue_fill, pending / static_cast<double>(pool.get().get_queue_capacity()));
+            }
+        }
+        r.busy_ratio = max_threads > 0 ? static_cast<double>(busy) / static_cast<double>(max_threads) : 0.0;
+
+        double pressure = std::max(r.queue_fill / limits.queue_limit, r.busy_ratio / 2.0);
+        if (limits.latency_ms > 0) {
+            pressure = std::max(pressure, r.latency_ms / limits.latency_ms);
+        }
+        if (limits.max_connections > 0) {
+            pressure = std::max(pressure, r.connections / limits.max_connections);
+        }
+        r.drain = m_draining.load(/* NOSONAR */ std::memory_order_relaxed) || pressure >= 1.0;
+        r.weight = r.drain ? 0 : static_cast<unsigned>(std::clamp(std::lround(100.0 * (1.0 - pressure)), 1L, 100L));
+        return r;
     }
 
     /**
@@ -285,6 +426,9 @@ public:
     std::atomic<long long> m_total_processing_time_us{0};
     std::atomic<int> m_connections{0};
     std::atomic<int> m_active_threads{0};
+    std::atomic<uint64_t> m_expired_requests{0};
+    std::atomic<long long> m_recent_latency_us{0};
+    std::atomic<bool> m_draining{false};
 
     mutable std::mutex m_pools_mutex;
     std::vector<std::reference_wrapper<const thread_pool>> m_thread_pools;
@@ -292,6 +436,42 @@ public:
     mutable std::mutex m_tasks_mutex;
     std::vector<task_info> m_active_tasks;
 
+    mutable std::mutex m_limiters_mutex;
+    std::vector<std::pair<std::string, std::shared_ptr<const concurrency_limiter>>> m_limiters;
+
+    mutable std::mutex m_usage_mutex;
+    std::vector<std::pair<std::string, std::shared_ptr<const handler_usage::endpoint_usage>>> m_usage;
+
+    struct limit_snapshot {
+        std::string path;
+        int limit;
+        int inflight;
+        uint64_t rejected;
+    };
+
+    struct usage_snapshot {
+        std::string path;
+        uint64_t requests;
+        double wall_s;
+        double cpu_s;
+        uint64_t voluntary;
+        uint64_t involuntary;
+    };
+
+    // One worker pool, summed over the I/O threads that each run a copy of it
+    struct pool_snapshot {
+        std::string name;
+        size_t threads{0};   // currently alive
+        size_t min_threads{0};
+        size_t max_threads{0};
+        size_t busy{0};
+        std::array<size_t, thread_pool::PRIORITY_LEVELS> pending{};
+        size_t capacity{0};  // shared by the priorities
+        uint64_t rejected{0};
+        uint64_t grown{0};   // resize events
+        uint64_t shrunk{0};
+    };
+
     /**
      * @brief Structure to hold a point-in-time snapshot of all metrics.
      * * Used to separate data collection logic from data formatting logic.
@@ -305,10 +485,15 @@ public:
         int current_connections;
         int active_threads;
         size_t pending_tasks;
+        uint64_t stolen_tasks;
+        uint64_t expired_requests;
         size_t pool_size;
         size_t memory_usage_kb;
         size_t total_ram_kb;
         double memory_usage_pct;
+        std::vector<limit_snapshot> limits;
+        std::vector<pool_snapshot> pools;
+        std::vector<usage_snapshot> usage;
     };
 
     /**
@@ -326,6 +511,7 @@ public:
         long long total_time_us = m_total_processing_time_us.load(/* NOSONAR */ std::memory_order_relaxed);
         s.current_connections = m_connections.load(/* NOSONAR */ std::memory_order_relaxed);
         s.active_threads = m_active_threads.load(/* NOSONAR */ std::memory_order_relaxed);
+        s.expired_requests = m_expired_requests.load(/* NOSONAR */ std::memory_order_relaxed);
         s.pool_size = m_pool_size;
 
         // 2. Static/Member Data
@@ -349,16 +535,164 @@ public:
 
         // 5. Locking Logic
         s.pending_tasks = 0;
+        s.stolen_tasks = 0;
         {
             std::scoped_lock lock(m_pools_mutex);
             for (const auto& pool : m_thread_pools) {
                 s.pending_tasks += pool.get().get_total_pending_tasks();
+                s.stolen_tasks += pool.get().get_stolen_tasks();
+                add_pool_snapshot(s.pools, pool.get());
+            }
+        }
+        {
+            std::scoped_lock lock(m_limiters_mutex);
+            s.limits.reserve(m_limiters.size());
+            for (const auto& [path, limiter] : m_limiters) {
+                s.limits.push_back({path, limiter->limit(), limiter->inflight(), limiter->rejected()});
+            }
+        }
+        {
+            std::scoped_lock lock(m_usage_mutex);
+            s.usage.reserve(m_usage.size());
+            for (const auto& [path, u] : m_usage) {
+                s.usage.push_back({path, u->requests(), static_cast<double>(u->wall_us()) / 1'000'000.0,
+                                   static_cast<double>(u->cpu_us()) / 1'000'000.0, u->voluntary_switches(), u->involuntary_switches()});
             }
         }
 
         return s;
     }
 
+    /**
+     * @brief Adds a pool's counters to the snapshot entry of the same name.
+     * @param pools The per-name entries, in registration order.
+     * @param pool The pool to add.
+     */
+    static void add_pool_snapshot(std::vector<pool_snapshot>& pools, const thread_pool& pool) {
+        auto it = std::ranges::find(pools, pool.get_name(), &pool_snapshot::name);
+        if (it == pools.end()) {
+            it = pools.insert(pools.end(), pool_snapshot{.name = pool.get_name()});
+        }
+        it->threads += pool.get_thread_count();
+        it->min_threads += pool.get_min_threads();
+        it->max_threads += pool.get_max_threads();
+        it->grown += pool.get_grow_events();
+        it->shrunk += pool.get_shrink_events();
+        it->busy += pool.get_busy_threads();
+        it->capacity += pool.get_queue_capacity();
+        it->rejected += pool.get_rejected_tasks();
+        for (size_t i = 0; i < thread_pool::PRIORITY_LEVELS; ++i) {
+            it->pending[i] += pool.get_pending_tasks(static_cast<thread_pool::priority>(i));
+        }
+    }
+
+    /**
+     * @brief Appends the per-pool saturation series to a Prometheus exposition.
+     * @details Busy threads over threads, and pending over capacity, tell how close each pool is to rejecting work.
+     * @param out The exposition being built.
+     * @param s The snapshot holding the pool values.
+     */
+    static void append_pool_metrics(std::string& out, const MetricsSnapshot& s) {
+        static constexpr std::array<std::string_view, thread_pool::PRIORITY_LEVELS> priority_names{"high", "normal", "low"};
+        out += "\n# HELP worker_pool_threads Worker threads per pool\n"
+               "# TYPE worker_pool_threads gauge\n";
+        for (const auto& p : s.pools) {
+            out += std::format("worker_pool_threads{{pod=\"{}\", pool=\"{}\"}} {}\n", s.pod_name, p.name, p.threads);
+        }
+        out += "\n# HELP worker_pool_min_threads Worker threads a pool never shrinks below\n"
+               "# TYPE worker_pool_min_threads gauge\n";
+        for (const auto& p : s.pools) {
+            out += std::format("worker_pool_min_threads{{pod=\"{}\", pool=\"{}\"}} {}\n", s.pod_name, p.name, p.min_threads);
+        }
+        out += "\n# HELP worker_pool_max_threads Worker threads a pool may grow to while its workers are blocked\n"
+               "# TYPE worker_pool_max_threads gauge\n";
+        for (const auto& p : s.pools) {
+            out += std::format("worker_pool_max_threads{{pod=\"{}\", pool=\"{}\"}} {}\n", s.pod_name, p.name, p.max_threads);
+        }
+        out += "\n# HELP worker_pool_resizes_total Workers added to or retired from a pool\n"
+               "# TYPE worker_pool_resizes_total counter\n";
+        for (const auto& p : s.pools) {
+            out += std::format("worker_pool_resizes_total{{pod=\"{}\", pool=\"{}\", direction=\"grow\"}} {}\n", s.pod_name, p.name, p.grown);
+            out += std::format("worker_pool_resizes_total{{pod=\"{}\", pool=\"{}\", direction=\"shrink\"}} {}\n", s.pod_name, p.name, p.shrunk);
+        }
+        out += "\n# HELP worker_pool_busy_threads Worker threads running a task per pool\n"
+               "# TYPE worker_pool_busy_threads gauge\n";
+        for (const auto& p : s.pools) {
+            out += std::format("worker_pool_busy_threads{{pod=\"{}\", pool=\"{}\"}} {}\n", s.pod_name, p.name, p.busy);
+        }
+        out += "\n# HELP worker_pool_pending_tasks Tasks waiting per pool and priority\n"
+               "# TYPE worker_pool_pending_tasks gauge\n";
+        for (const auto& p : s.pools) {
+            for (size_t i = 0; i < thread_pool::PRIORITY_LEVELS; ++i) {
+                out += std::format("worker_pool_pending_tasks{{pod=\"{}\", pool=\"{}\", priority=\"{}\"}} {}\n", 
+                                   s.pod_name, p.name, priority_names[i], p.pending[i]);
+            }
+        }
+        out += "\n# HELP worker_pool_queue_capacity Queue slots per pool, shared by all priorities\n"
+               "# TYPE worker_pool_queue_capacity gauge\n";
+        for (const auto& p : s.pools) {
+            out += std::format("worker_pool_queue_capacity{{pod=\"{}\", pool=\"{}\"}} {}\n", s.pod_name, p.name, p.capacity);
+        }
+        out += "\n# HELP worker_pool_rejected_total Tasks rejected because the pool's queue was full\n"
+               "# TYPE worker_pool_rejected_total counter\n";
+        for (const auto& p : s.pools) {
+            out += std::format("worker_pool_rejected_total{{pod=\"{}\", pool=\"{}\"}} {}\n", s.pod_name, p.name, p.rejected);
+        }
+    }
+
+    /**
+     * @brief Appends the per-endpoint concurrency limiter series to a Prometheus exposition.
+     * @param out The exposition being built.
+     * @param s The snapshot holding the limiter values.
+     */
+    static void append_limit_metrics(std::string& out, const MetricsSnapshot& s) {
+        out += "\n# HELP http_concurrency_limit Adaptive concurrency limit per endpoint\n"
+               "# TYPE http_concurrency_limit gauge\n";
+        for (const auto& l : s.limits) {
+            out += std::format("http_concurrency_limit{{pod=\"{}\", path=\"{}\"}} {}\n", s.pod_name, l.path, l.limit);
+        }
+        out += "\n# HELP http_concurrency_inflight Requests admitted and not yet answered per endpoint\n"
+               "# TYPE http_concurrency_inflight gauge\n";
+        for (const auto& l : s.limits) {
+            out += std::format("http_concurrency_inflight{{pod=\"{}\", path=\"{}\"}} {}\n", s.pod_name, l.path, l.inflight);
+        }
+        out += "\n# HELP http_requests_shed_total Requests rejected by the concurrency limiter per endpoint\n"
+               "# TYPE http_requests_shed_total counter\n";
+        for (const auto& l : s.limits) {
+            out += std::format("http_requests_shed_total{{pod=\"{}\", path=\"{}\"}} {}\n", s.pod_name, l.path, l.rejected);
+        }
+    }
+
+    /**
+     * @brief Appends the per-endpoint handler usage series to a Prometheus exposition.
+     * @details rate(cpu) over rate(wall) tells computing endpoints (add cores) from waiting ones (add connections).
+     * @param out The exposition being built.
+     * @param s The snapshot holding the usage values.
+     */
+    static void append_usage_metrics(std::string& out, const MetricsSnapshot& s) {
+        out += "\n# HELP http_handler_requests_total Handler runs measured per endpoint\n"
+               "# TYPE http_handler_requests_total counter\n";
+        for (const auto& u : s.usage) {
+            out += std::format("http_handler_requests_total{{pod=\"{}\", path=\"{}\"}} {}\n", s.pod_name, u.path, u.requests);
+        }
+        out += "\n# HELP http_handler_wall_seconds_total Wall-clock time spent in the handler per endpoint\n"
+               "# TYPE http_handler_wall_seconds_total counter\n";
+        for (const auto& u : s.usage) {
+            out += std::format("http_handler_wall_seconds_total{{pod=\"{}\", path=\"{}\"}} {:.6f}\n", s.pod_name, u.path, u.wall_s);
+        }
+        out += "\n# HELP http_handler_cpu_seconds_total Thread CPU time spent in the handler per endpoint\n"
+               "# TYPE http_handler_cpu_seconds_total counter\n";
+        for (const auto& u : s.usage) {
+            out += std::format("http_handler_cpu_seconds_total{{pod=\"{}\", path=\"{}\"}} {:.6f}\n", s.pod_name, u.path, u.cpu_s);
+        }
+        out += "\n# HELP http_handler_context_switches_total Context switches during the handler per endpoint: voluntary (waiting) or involuntary (preempted)\n"
+               "# TYPE http_handler_context_switches_total counter\n";
+        for (const auto& u : s.usage) {
+            out += std::format("http_handler_context_switches_total{{pod=\"{}\", path=\"{}\", kind=\"voluntary\"}} {}\n", s.pod_name, u.path, u.voluntary);
+            out += std::format("http_handler_context_switches_total{{pod=\"{}\", path=\"{}\", kind=\"involuntary\"}} {}\n", s.pod_name, u.path, u.involuntary);
+        }
+    }
+
     /**
      * @brief Ultimate Fallback: Raw system time (effectively UTC)
      * @return std::string Formatted timestamp string (ISO 8601-like).
@@ -405,4 +739,4 @@ public:
     }
     };
 
-    #endif // METRICS_HPP
\ No newline at end of file
+    #endif // METRICS_HPP
\ No newline at end of file
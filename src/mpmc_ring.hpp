@@ -0,0 +1,113 @@
+#ifndef MPMC_RING_HPP
+#define MPMC_RING_HPP
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <algorithm>
+
+/**
+ * @brief Bounded lock-free multi-producer, multi-consumer ring (Dmitry Vyukov's design).
+ *
+ * Each cell carries a sequence number that says whose turn it is: producers claim the enqueue
+ * position with one CAS, fill the cell and publish it by advancing its sequence; consumers do the
+ * same on the dequeue side. Producers and consumers only contend with their own kind, and a full or
+ * empty ring is detected without locks. Slots are preallocated; the capacity is rounded up to a power of two.
+ *
+ * @tparam T Default-constructible, nothrow-movable item type.
+ */
+template<typename T>
+class mpmc_ring {
+public:
+    explicit mpmc_ring(size_t capacity)
+        : m_mask(std::bit_ceil(std::max<size_t>(capacity, 2)) - 1),
+          m_cells(std::make_unique<cell[]>(m_mask + 1)) {
+        for (size_t i = 0; i <= m_mask; ++i) {
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    mpmc_ring(const mpmc_ring&) = delete;
+    mpmc_ring& operator=(const mpmc_ring&) = delete;
+    mpmc_ring(mpmc_ring&&) = delete;
+    mpmc_ring& operator=(mpmc_ring&&) = delete;
+    ~mpmc_ring() = default;
+
+    // Moves from item only on success; false if the ring is full
+    [[nodiscard]] bool try_push(T& item) noexcept {
+        size_t pos = m_enqueue.load(std::memory_order_relaxed);
+        while (true) {
+            cell& c = m_cells[pos & m_mask];
+            const size_t seq = c.sequence.load(std::memory_order_acquire);
+            const auto dif = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (dif == 0 && m_enqueue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                c.value = std::move(item);
+                c.sequence.store(pos + 1, std::memory_order_release);
+                return true;
+            }
+            if (dif < 0) {
+                return false; // the consumers have not freed this cell yet
+            }
+            if (dif > 0) {
+                pos = m_enqueue.load(std::memory_order_relaxed); // another producer took it
+            }
+        }
+    }
+
+    // False if the ring is empty
+    [[nodiscard]] bool try_pop(T& out) noexcept {
+        size_t pos = m_dequeue.load(std::memory_order_relaxed);
+        while (true) {
+            cell& c = m_cells[pos & m_mask];
+            const size_t seq = c.sequence.load(std::memory_order_acquire);
+            const auto dif = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+            if (dif == 0 && m_dequeue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                out = std::move(c.value);
+                c.sequence.store(pos + m_mask + 1, std::memory_order_release);
+                return true;
+            }
+            if (dif < 0) {
+                return false; // nothing published at the head
+            }
+            if (dif > 0) {
+                pos = m_dequeue.load(std::memory_order_relaxed); // another consumer took it
+            }
+        }
+    }
+
+    // True if no item is published at the head; a producer may be filling it
+    [[nodiscard]] bool empty() const noexcept {
+        const size_t pos = m_dequeue.load(std::memory_order_acquire);
+        const size_t seq = m_cells[pos & m_mask].sequence.load(std::memory_order_acquire);
+        return static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1) < 0;
+    }
+
+    // Approximate under concurrent use
+    [[nodiscard]] size_t size() const noexcept {
+        const size_t head = m_dequeue.load(std::memory_order_relaxed);
+        const size_t tail = m_enqueue.load(std::memory_order_relaxed);
+        return tail > head ? tail - head : 0;
+    }
+
+    [[nodiscard]] size_t capacity() const noexcept {
+        return m_mask + 1;
+    }
+
+private:
+    struct cell {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    static constexpr size_t CACHE_LINE{64};
+
+    // Producers and consumers each spin on their own cache line
+    alignas(CACHE_LINE) std::atomic<size_t> m_enqueue{0};
+    alignas(CACHE_LINE) std::atomic<size_t> m_dequeue{0};
+    const size_t m_mask;
+    std::unique_ptr<cell[]> m_cells;
+};
+
+#endif // MPMC_RING_HPP
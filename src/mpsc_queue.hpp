@@ -0,0 +1,111 @@
+#ifndef MPSC_QUEUE_HPP
+#define MPSC_QUEUE_HPP
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <memory>
+#include <unistd.h>
+
+/**
+ * @brief Intrusive lock-free multi-producer, single-consumer queue that wakes its consumer through an eventfd.
+ *
+ * Items carry their own link (a `T* next` member), so a push allocates nothing: the producer hands over
+ * an item it already owns and the consumer takes ownership of it. Producers link an item onto an atomic
+ * list head with one CAS; the consumer takes the whole list with one exchange and reverses it, so each
+ * producer's items come out in the order it pushed them. Only the push that finds the list empty writes
+ * the eventfd: a burst of N pushes costs one syscall, not N. The consumer must read the eventfd before
+ * drain(), so any push that lands after the drain finds the list empty again and signals. Taking the
+ * whole list at once also rules out ABA.
+ *
+ * @tparam T The type of items in the queue, with a `T* next` member the queue owns while it is queued.
+ */
+template<typename T>
+class mpsc_queue {
+public:
+    mpsc_queue() = default;
+
+    // Rule of 5: producers hold pointers to the queue
+    mpsc_queue(const mpsc_queue&) = delete;
+    mpsc_queue& operator=(const mpsc_queue&) = delete;
+    mpsc_queue(mpsc_queue&&) = delete;
+    mpsc_queue& operator=(mpsc_queue&&) = delete;
+
+    ~mpsc_queue() {
+        T* item = m_head.exchange(nullptr, std::memory_order_acquire);
+        while (item != nullptr) {
+            std::unique_ptr<T> owned(item);
+            item = item->next;
+        }
+    }
+
+    void set_event_fd(int fd) noexcept {
+        m_event_fd.store(fd, /* NOSONAR */ std::memory_order_release);
+    }
+
+    // Any thread; the item belongs to the consumer from here on
+    void push(std::unique_ptr<T> item) noexcept {
+        T* n = item.release();
+        T* head = m_head.load(std::memory_order_relaxed);
+        do {
+            n->next = head; // n is owned by the consumer once published: only head may be read after the CAS
+        } while (!m_head.compare_exchange_weak(head, n, std::memory_order_release, std::memory_order_relaxed));
+        if (head == nullptr) {
+            notify_event_fd(); // empty -> non-empty: the consumer may be asleep
+        }
+    }
+
+    // Consumer thread only; passes every queued item to f in push order (per producer)
+    template<typename F>
+    void drain(F&& f) {
+        T* reversed = m_head.exchange(nullptr, std::memory_order_acquire);
+        T* list = nullptr;
+        while (reversed != nullptr) {
+            T* next = reversed->next;
+            reversed->next = list;
+            list = reversed;
+            reversed = next;
+        }
+        try {
+            while (list != nullptr) {
+                std::unique_ptr<T> item(list);
+                list = list->next;
+                item->next = nullptr;
+                f(std::move(item));
+            }
+        } catch (...) {
+            while (list != nullptr) {
+                std::unique_ptr<T> owned(list);
+                list = list->next;
+            }
+            throw;
+        }
+    }
+
+    [[nodiscard]] bool empty() const noexcept {
+        return m_head.load(std::memory_order_acquire) == nullptr;
+    }
+
+    // Wakes the consumer so it notices shutdown
+    void stop() noexcept {
+        notify_event_fd();
+    }
+
+private:
+    // Uses do-while to satisfy SonarCloud's "no infinite loops" rule
+    void notify_event_fd() const noexcept {
+        int fd = m_event_fd.load(/* NOSONAR */ std::memory_order_acquire);
+        if (fd != -1) {
+            uint64_t u = 1;
+            ssize_t s;
+            do {
+                s = write(fd, &u, sizeof(uint64_t));
+            } while (s == -1 && errno == EINTR);
+        }
+    }
+
+    std::atomic<T*> m_head{nullptr};
+    std::atomic<int> m_event_fd{-1};
+};
+
+#endif // MPSC_QUEUE_HPP
@@ -48,7 +48,7 @@ public:
         };
 
         // Propagate x-request-id if present in the original request
-        if (auto request_id_opt = req.get_header_value("x-request-id"); request_id_opt) {
+        if (auto request_id_opt = req.get_header_value(http::header_id::x_request_id); request_id_opt) {
             headers.try_emplace("x-request-id", *request_id_opt);
         }
 
@@ -94,7 +94,7 @@ private:
 
         std::map<std::string, std::string, std::less<>> headers = {{"Content-Type", "application/json"}};
         
-        if (auto request_id_opt = req.get_header_value("x-request-id"); request_id_opt) {
+        if (auto request_id_opt = req.get_header_value(http::header_id::x_request_id); request_id_opt) {
             headers.try_emplace("x-request-id", *request_id_opt);
         }
 
@@ -2,11 +2,17 @@
 #include "shared_queue.hpp"
 #include "util.hpp"
 #include "sql.hpp"
+#include "async_sql.hpp"
 #include "jwt.hpp"
 #include "cors.hpp"
 #include "http_client.hpp"
 #include <sys/timerfd.h>
 #include <sys/eventfd.h>
+#include <sys/uio.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <poll.h>
 #include <system_error>
 #include <format>
 #include <cstring>
@@ -17,6 +23,8 @@
 #include <algorithm>
 #include <numeric>
 #include <ranges>
+#include <charconv>
+#include <optional>
 
 using namespace std::chrono_literals;
 using namespace std::string_view_literals;
@@ -28,27 +36,43 @@ server::io_worker::io_worker(uint16_t port,
                              std::shared_ptr<metrics> metrics_ptr, 
                              const api_router& router,
                              const std::unordered_set<std::string, util::string_hash, util::string_equal>& allowed_origins,
-                             int worker_thread_count,
-                             size_t queue_capacity,
-                             std::atomic<bool>& running_flag)
+                             const std::vector<worker_pool_config>& pools,
+                             std::atomic<bool>& running_flag,
+                             affinity::placement placement)
     : m_port(port),
       m_metrics(metrics_ptr), 
       m_router(router),
       m_allowed_origins(allowed_origins),
-      m_running(running_flag) {
+      m_running(running_flag),
+      m_placement(std::move(placement)),
+      m_buffers(env::get<bool>("BUFFER_HUGE_PAGES", false)) {
           
-    m_thread_pool = std::make_unique<thread_pool>(worker_thread_count, queue_capacity);
-    m_response_queue = std::make_unique<shared_queue<response_item, true>>(); 
+    const auto grow_after = std::chrono::milliseconds(env::get<int>("POOL_GROW_AFTER_MS", 10));
+    const auto idle_timeout = std::chrono::seconds(env::get<int>("POOL_IDLE_SECONDS", 60));
+    m_pools.reserve(pools.size());
+    for (const auto& pool : pools) {
+        const thread_pool::sizing size{static_cast<size_t>(pool.threads), static_cast<size_t>(pool.max_threads), grow_after, idle_timeout};
+        m_pools.push_back(std::make_unique<thread_pool>(size, pool.queue_capacity, pool.name));
+    }
+    m_response_queue = std::make_unique<mpsc_queue<worker_job>>();
     
     m_api_key = env::get<std::string>("API_KEY", "");
     m_mfa_uri = env::get<std::string>("MFA_URI", "/validate/totp");    
+    m_pipeline_depth = std::max(1uz, env::get<size_t>("PIPELINE_DEPTH", 16uz));
+    m_use_io_ring = env::get<std::string>("IO_BACKEND", "epoll") == "uring";
+    m_direct_write = env::get<bool>("DIRECT_WRITE", false);
+    m_header_timeout = std::chrono::seconds(env::get<int>("HEADER_TIMEOUT_SECONDS", 10));
+    m_body_timeout = std::chrono::seconds(env::get<int>("BODY_TIMEOUT_SECONDS", 30));
+    m_idle_timeout = std::chrono::seconds(env::get<int>("IDLE_TIMEOUT_SECONDS", 60));
+    m_write_timeout = std::chrono::seconds(env::get<int>("WRITE_TIMEOUT_SECONDS", 30));
+    m_request_timeout = std::chrono::seconds(env::get<int>("REQUEST_TIMEOUT_SECONDS", 30));
 }
 
 server::io_worker::~io_worker() noexcept {
     if (m_timer_fd != -1) close(m_timer_fd);
     if (m_event_fd != -1) close(m_event_fd);
     if (m_listening_fd != -1) close(m_listening_fd);
-    if (m_thread_pool) m_thread_pool->stop();
+    for (const auto& pool : m_pools) pool->stop();
     if (m_epoll_fd != -1) close(m_epoll_fd);
 }
 
@@ -56,14 +80,8 @@ void server::io_worker::setup_timerfd() {
     m_timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
     if (m_timer_fd == -1) throw server_error("Failed to create timerfd");
 
-    struct itimerspec ts{};
-    ts.it_value.tv_sec = 5;      
-    ts.it_interval.tv_sec = 5;   
-    
-    if (timerfd_settime(m_timer_fd, 0, &ts, nullptr) == -1) {
-        throw server_error("Failed to set timerfd interval");
-    }
-    add_to_epoll(m_timer_fd, EPOLLIN);
+    // Starts disarmed: arm_timer() sets it for the timing wheel's next non-empty slot
+    watch_fd(m_timer_fd);
 }
 
 void server::io_worker::setup_eventfd() {
@@ -71,57 +89,101 @@ void server::io_worker::setup_eventfd() {
     if (m_event_fd == -1) throw server_error("Failed to create eventfd");
 
     m_response_queue->set_event_fd(m_event_fd);
-    add_to_epoll(m_event_fd, EPOLLIN);
+    watch_fd(m_event_fd);
 }
 
 void server::io_worker::setup_shutdown_fd() {
     m_shutdown_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
     if (m_shutdown_fd == -1) throw server_error("Failed to create shutdown eventfd");
-    add_to_epoll(m_shutdown_fd, EPOLLIN);
+    watch_fd(m_shutdown_fd);
+}
+
+// Must run on the I/O thread itself: the ring is created single-issuer
+void server::io_worker::setup_io_ring() {
+    try {
+        m_ring = std::make_unique<io_ring>(server::RING_ENTRIES);
+        m_recv_buffers = std::make_unique<provided_buffer_ring>(*m_ring, 0, server::RING_RECV_BUFFERS, server::RING_RECV_BUFFER_SIZE);
+        util::log::debug("I/O worker thread {} using the io_uring backend.", std::this_thread::get_id());
+    } catch (const io_ring_error& e) {
+        util::log::warn("io_uring backend unavailable ({}), falling back to epoll.", e.what());
+        m_recv_buffers.reset();
+        m_ring.reset();
+    }
+}
+
+// Registers an internal fd (listeners, timer, eventfds) with the backend driving this worker
+void server::io_worker::watch_fd(int fd) {
+    if (!m_ring && fd == m_unix_fd) {
+        // Every worker polls the same Unix listener: wake one of them per connection, not all
+        epoll_event event{};
+        event.events = EPOLLIN | EPOLLEXCLUSIVE;
+        event.data.u64 = static_cast<uint64_t>(fd);
+        if (epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, fd, &event) == -1) {
+            throw server_error("epoll_ctl ADD failed for the Unix listener");
+        }
+    } else if (!m_ring) {
+        add_to_epoll(fd, EPOLLIN, static_cast<uint64_t>(fd)); // generation 0: not a connection
+    } else if (fd == m_listening_fd || fd == m_unix_fd) {
+        arm_accept(fd);
+    } else {
+        arm_poll(fd);
+    }
 }
 
 // Extracted to fix SonarCloud Cognitive Complexity > 15
 void server::io_worker::handle_epoll_event(const epoll_event& event) {
-    const int fd = event.data.fd;
+    const uint64_t key = event.data.u64;
     const uint32_t ev = event.events;
 
-    if (fd == m_listening_fd) {
-        on_connect();
-        return;
-    } 
-    if (fd == m_timer_fd) {
-        on_timer_tick();
-        return;
-    } 
-    if (fd == m_event_fd) {
-        on_response_ready();
-        return;
+    // The reactor's own fds are registered with generation 0, so their key is the bare fd
+    if ((key >> 32) == 0) {
+        const auto fd = static_cast<int>(key);
+        if (fd == m_listening_fd || fd == m_unix_fd) {
+            on_connect(fd);
+        } else if (fd == m_timer_fd) {
+            on_timer_tick();
+        } else if (fd == m_event_fd) {
+            on_response_ready();
+        }
+        return; // shutdown fd: wake up and check m_running
     }
-    if (fd == m_shutdown_fd) {
-        return; // Wake up and check m_running
+
+    // Null if the connection was closed earlier in this batch, even if its slot was reused since
+    connection_state* conn = m_connections.find(key);
+    if (conn == nullptr) {
+        return;
     }
+    conn->armed_events = 0; // EPOLLONESHOT disarmed the fd when this event fired
     
     if ((ev & EPOLLIN) != 0) {
-        on_read(fd);
+        on_read(*conn);
     }
     
-    if ((ev & EPOLLOUT) != 0) {
-        on_write(fd);
+    // Each step may close the connection; the slot itself stays valid, so re-check by key
+    if ((ev & EPOLLOUT) != 0 && m_connections.find(key) != nullptr) {
+        on_write(*conn);
     }
     
     // Flattened nested 'if' statements to pass Sonar checks
-    if ((ev & (EPOLLERR | EPOLLHUP)) != 0 && m_connections.contains(fd)) {
-        close_connection(fd);
+    if (m_connections.find(key) == nullptr) {
+        return;
+    }
+    if ((ev & (EPOLLERR | EPOLLHUP)) != 0) {
+        close_connection(*conn);
     } else if ((ev & EPOLLRDHUP) != 0) {
-        if (auto it = m_connections.find(fd); it != m_connections.end()) {
-            it->second.close_after_write = true;
-        }
+        conn->close_after_write = true;
     }
 }
 
 void server::io_worker::run() {
+    // Pool threads inherit the pool mask when started below; the reactor then narrows to its own CPU
+    affinity::pin_current_thread(m_placement.pool_cpus);
+    m_buffers.bind_to_current_thread();
     try {
-        setup_listening_socket();
+        if (m_use_io_ring) {
+            setup_io_ring();
+        }
+        setup_epoll();
         setup_timerfd();
         setup_eventfd();
         setup_shutdown_fd();
@@ -131,8 +193,20 @@ void server::io_worker::run() {
     }
 
     util::log::debug("I/O worker thread {} started and listening on port {}.", std::this_thread::get_id(), m_port);
-    m_thread_pool->start();
-    
+    for (const auto& pool : m_pools) pool->start();
+    if (m_placement.pinned()) {
+        affinity::pin_current_thread(std::span(m_placement.cpus).first(1));
+    }
+
+    if (m_ring) {
+        run_io_ring();
+    } else {
+        run_epoll();
+    }
+    util::log::debug("I/O worker thread {} finished.", std::this_thread::get_id());
+}
+
+void server::io_worker::run_epoll() {
     std::vector<epoll_event> events(MAX_EVENTS);
 
     while (m_running) {
@@ -143,85 +217,197 @@ void server::io_worker::run() {
             return;
         }
 
+        // Responses a worker already sent free their pipeline slot before this batch's reads,
+        // so the next request on the connection can be handed the socket as well
+        if (m_direct_write && !m_response_queue->empty()) {
+            process_response_queue();
+        }
         for (int i = 0; i < num_events; ++i) {
             handle_epoll_event(events[i]);
         }
     }
     drain_pending_responses();
-    util::log::debug("I/O worker thread {} finished.", std::this_thread::get_id());
 }
 
 void server::io_worker::on_timer_tick() {
     uint64_t expirations;
     if (read(m_timer_fd, &expirations, sizeof(expirations)) > 0) {
+        m_timer_armed_at = timing_wheel::clock::time_point::max();
         check_timeouts();
     }
+    // Multishot accept stops on EMFILE/ENFILE; on_ring_accept() arms a tick to retry
+    if (m_ring && !m_accept_armed && m_running) {
+        arm_accept(m_listening_fd);
+    }
+    if (m_ring && m_unix_fd != -1 && !m_unix_accept_armed && m_running) {
+        arm_accept(m_unix_fd);
+    }
 }
 
 void server::io_worker::check_timeouts() {
-    auto now = std::chrono::steady_clock::now();
-    auto it_list = m_timeout_list.begin();
-    
-    while (it_list != m_timeout_list.end()) {
-        int fd = *it_list;
-        auto it_conn = m_connections.find(fd);
-        
-        if (it_conn == m_connections.end()) {
-            it_list = m_timeout_list.erase(it_list);
-            continue;
+    m_timers.advance(timing_wheel::clock::now(), [this](uint64_t key) {
+        connection_state* found = m_connections.find(key);
+        if (found == nullptr) return;
+
+        auto& conn = *found;
+        conn.timer = timing_wheel::npos;
+        // Idle keep-alive expiry is routine; the others point at slow or stalled clients
+        if (conn.deadline == deadline_kind::header || conn.deadline == deadline_kind::body) {
+            util::log::warn("Request {} timeout on fd {} from {}, closing connection.",
+                conn.deadline == deadline_kind::header ? "header" : "body", conn.fd, conn.remote_ip);
+        } else if (conn.deadline == deadline_kind::write) {
+            util::log::warn("Write stalled on fd {} from {}, closing connection.", conn.fd, conn.remote_ip);
         }
+        close_connection(conn);
+    });
+    if (auto next = m_timers.next_expiry()) {
+        arm_timer(*next);
+    }
+}
 
-        // Exemption: Do not timeout connections currently executing a heavy API task
-        if (it_conn->second.is_processing) {
-            ++it_list;
-            continue;
-        }
+// Arms the timerfd (absolute CLOCK_MONOTONIC, same clock as steady_clock) unless an earlier expiry is already armed
+void server::io_worker::arm_timer(timing_wheel::clock::time_point when) {
+    if (when >= m_timer_armed_at) return;
+    m_timer_armed_at = when;
+
+    const auto since_epoch = std::max(when.time_since_epoch(), timing_wheel::clock::duration{1}); // zero would disarm
+    const auto secs = std::chrono::duration_cast<std::chrono::seconds>(since_epoch);
+    itimerspec ts{};
+    ts.it_value.tv_sec = secs.count();
+    ts.it_value.tv_nsec = std::chrono::duration_cast<std::chrono::nanoseconds>(since_epoch - secs).count();
+    if (timerfd_settime(m_timer_fd, TFD_TIMER_ABSTIME, &ts, nullptr) == -1) {
+        util::log::error("timerfd_settime failed in worker {}: {}", std::this_thread::get_id(), util::str_error_cpp(errno));
+    }
+}
 
-        // Reversed logic to eliminate 'else' branch (SonarCloud optimization)
-        if (now - it_conn->second.last_activity <= server::READ_TIMEOUT) {
-            break;
-        }
+std::chrono::seconds server::io_worker::timeout_for(deadline_kind kind) const noexcept {
+    using enum deadline_kind;
+    switch (kind) {
+        case header: return m_header_timeout;
+        case body: return m_body_timeout;
+        case idle: return m_idle_timeout;
+        case write: return m_write_timeout;
+        case none: break;
+    }
+    return std::chrono::seconds::zero();
+}
 
-        remove_from_epoll(fd);
-        close(fd);
-        m_metrics->decrement_connections();
-        m_connections.erase(it_conn);
-        it_list = m_timeout_list.erase(it_list);
+// Picks the deadline matching the connection state. Header and body deadlines run from when that
+// phase began, so trickling bytes (slow-loris) cannot extend them; a write deadline restarts on progress.
+void server::io_worker::update_deadline(connection_state& conn, bool write_progress) {
+    using enum deadline_kind;
+    deadline_kind next = none;
+    if (conn.write_blocked || conn.sends_in_flight > 0) {
+        next = write;
+    } else if (!conn.pipeline.empty()) {
+        next = none; // requests being processed are exempt
+    } else if (conn.parser.has_data() || conn.next_sequence == 0) {
+        next = conn.parser.headers_complete() ? body : header;
+    } else {
+        next = idle;
+    }
+
+    if (next == conn.deadline && !(next == write && write_progress)) return;
+
+    m_timers.cancel(conn.timer);
+    conn.timer = timing_wheel::npos;
+    conn.deadline = next;
+    if (next == none) return;
+
+    conn.timer = m_timers.schedule(timing_wheel::clock::now() + timeout_for(next), conn.key());
+    if (auto expiry = m_timers.next_expiry()) {
+        arm_timer(*expiry);
     }
 }
 
+// Resets the eventfd before draining: a response pushed after the drain finds the queue empty and signals again
 void server::io_worker::on_response_ready() {
     uint64_t val;
     [[maybe_unused]] ssize_t s = read(m_event_fd, &val, sizeof(val));
     process_response_queue();
 }
 
+// Each job is freed here, so its request buffer goes back to this io_worker's pool from its own thread
 void server::io_worker::process_response_queue() {
-    std::vector<response_item> response_batch;
-    response_batch.reserve(64); 
+    m_response_queue->drain([this](std::unique_ptr<worker_job> item) {
+        // Flattened nested 'if' to pass Sonar checks
+        connection_state* conn = m_connections.find(item->slot, item->generation);
+        if (conn != nullptr && item->sequence == conn->write_sequence) {
+            conn->worker_writes = false; // the socket is back with the reactor
+        }
+        if (conn != nullptr && conn->close_deferred && !conn->worker_writes) {
+            close_connection(*conn);
+        } else if (conn != nullptr && conn->deliver(item->sequence, std::move(item->res))) {
+            write_delivered(*conn);
+        } else {
+            util::log::warn("Dropped stale response for closed connection slot {}", item->slot);
+        }
+    });
+}
 
-    m_response_queue->drain_to(response_batch);
+// A response written in full by its worker (DIRECT_WRITE) leaves only the bookkeeping and the keep-alive re-arm
+void server::io_worker::write_delivered(connection_state& conn) {
+    if (!conn.head_ready() || conn.pipeline.front()->available_size() > 0) {
+        do_write(conn.fd, conn);
+        return;
+    }
+    conn.consume_written(0);
+    if (conn.ready_to_close()) {
+        close_connection(conn);
+        return;
+    }
+    process_buffered_requests(conn.fd, conn);
+}
 
-    for (auto& item : response_batch) {
-        // Flattened nested 'if' to pass Sonar checks
-        auto it = m_connections.find(item.client_fd);
-        if (it != m_connections.end() && it->second.connection_id == item.connection_id) {
-            it->second.is_processing = false; // Worker is done, resume standard timeouts
-            it->second.response = std::move(item.res);
-            do_write(item.client_fd, it->second);
+// Stops accepting and winds down keep-alive connections: idle ones are closed now, the others after
+// their last response. The listening socket stays open, so a successor holding it keeps accepting.
+void server::io_worker::begin_drain() {
+    m_drain_deadline = timing_wheel::clock::now() + m_write_timeout;
+    for (const int fd : {m_listening_fd, m_unix_fd}) {
+        if (fd == -1) continue;
+        if (m_ring) {
+            auto& sqe = m_ring->get_sqe();
+            sqe.opcode = IORING_OP_ASYNC_CANCEL;
+            sqe.addr = ring_tag(ring_op::accept, static_cast<uint32_t>(fd), 0);
+            sqe.user_data = ring_tag(ring_op::cancel, static_cast<uint32_t>(fd), 0);
         } else {
-            util::log::warn("Dropped stale response for reused fd {}", item.client_fd);
+            remove_from_epoll(fd);
         }
     }
+
+    m_connections.for_each([this](connection_state& conn) {
+        char byte = 0;
+        const bool idle = conn.pipeline.empty() && conn.next_sequence > 0 && !conn.parser.has_data()
+            && recv(conn.fd, &byte, 1, MSG_PEEK | MSG_DONTWAIT) <= 0;
+        if (idle) {
+            close_connection(conn);
+        } else if (!conn.pipeline.empty()) {
+            conn.close_after_write = true;
+        }
+        // New connections and requests being received are served once, see process_request()
+    });
+    util::log::info("Waiting for {} unfinished tasks and {} open connections to complete...", 
+        unfinished_tasks(), m_connections.size());
+}
+
+size_t server::io_worker::unfinished_tasks() const {
+    size_t unfinished = 0;
+    for (const auto& pool : m_pools) unfinished += pool->get_unfinished_tasks();
+    return unfinished + m_coroutine_requests.load(std::memory_order_acquire);
+}
+
+// Responses still owed to clients; connections that stop reading are abandoned at the write timeout
+bool server::io_worker::draining() const {
+    return unfinished_tasks() > 0 || !m_response_queue->empty()
+        || (m_connections.size() > 0 && timing_wheel::clock::now() < m_drain_deadline);
 }
 
 void server::io_worker::drain_pending_responses() {
     util::log::info("I/O worker thread shutting down. Draining pending responses...");
     std::vector<epoll_event> events(MAX_EVENTS);
 
-    util::log::info("Waiting for {} unfinished tasks to complete...", m_thread_pool->get_unfinished_tasks());
-
-    while (m_thread_pool->get_unfinished_tasks() > 0 || m_response_queue->size() > 0) {
+    begin_drain();
+    while (draining()) {
         process_response_queue();
         
         const int num_events = epoll_wait(m_epoll_fd, events.data(), static_cast<int>(events.size()), 10);
@@ -233,29 +419,10 @@ void server::io_worker::drain_pending_responses() {
         }
 
         for (int i = 0; i < num_events; ++i) {
-            int fd = events[i].data.fd;
-            uint32_t ev = events[i].events;
-
-            if (fd == m_listening_fd || fd == m_timer_fd || fd == m_event_fd) {
-                continue;
-            }
-
-            if ((ev & EPOLLOUT) != 0) {
-                on_write(fd);
-            }
-            
-            // Extract the connection lookup to prevent a 4th level of nesting
-            auto it = m_connections.find(fd);
-            if (it == m_connections.end()) {
-                continue; // The connection was already closed (perhaps by on_write hitting EOF)
-            }
-
-            // The remaining logic is now safely flattened to a maximum depth of 3
-            if ((ev & (EPOLLERR | EPOLLHUP | EPOLLIN)) != 0) {
-                close_connection(fd);
-            } else if ((ev & EPOLLRDHUP) != 0) {
-                it->second.close_after_write = true;
-            }
+            // A connection already waiting in the batch is left to the accept queue's other owners
+            const uint64_t key = events[i].data.u64;
+            if (key == static_cast<uint64_t>(m_listening_fd) || key == static_cast<uint64_t>(m_unix_fd)) continue;
+            handle_epoll_event(events[i]);
         }
     }
     util::log::info("I/O worker thread drain complete.");
@@ -300,33 +467,58 @@ bool server::io_worker::validate_token(const http::request& req) const {
 }
 
 void server::io_worker::execute_handler(const http::request& request_ref, http::response& res, const api_endpoint* endpoint) const {
-    using enum http::status;
+    // Token checks included: JWT verification is CPU spent on behalf of the endpoint
+    const auto probe = endpoint->usage ? std::optional(handler_usage::probe::start()) : std::nullopt;
     try {
-        if (endpoint->method != request_ref.get_method()) {
-            res.set_body(bad_request, R"({"error":"Method Not Allowed"})");
-            return;
+        if (admit_request(request_ref, res, endpoint)) {
+            endpoint->handler(request_ref, res);
         }
+    } catch (...) {
+        set_error_response(request_ref, res, std::current_exception());
+    }
+    if (probe) {
+        endpoint->usage->record(probe->stop());
+    }
+}
 
-        if (endpoint->is_secure && !validate_token(request_ref)) {
-            res.set_body(http::status::unauthorized, R"({"error":"Invalid or missing token"})");
-            return;
-        }
+// Method, token and input checks before the handler runs; false when res already holds the rejection
+bool server::io_worker::admit_request(const http::request& request_ref, http::response& res, const api_endpoint* endpoint) const {
+    using enum http::status;
+    if (endpoint->method != request_ref.get_method()) {
+        res.set_body(bad_request, R"({"error":"Method Not Allowed"})");
+        return false;
+    }
+
+    if (endpoint->is_secure && !validate_token(request_ref)) {
+        res.set_body(http::status::unauthorized, R"({"error":"Invalid or missing token"})");
+        return false;
+    }
 
-        if(endpoint->is_secure)
-            util::log::debug("Authenticated request by user '{}' with sessionId '{}' for path '{}' from {}",
-                request_ref.get_user(),
-                request_ref.get_sessionId(),
-                request_ref.get_path(),
-                request_ref.get_remote_ip()
-            );
+    if(endpoint->is_secure)
+        util::log::debug("Authenticated request by user '{}' with sessionId '{}' for path '{}' from {}",
+            request_ref.get_user(),
+            request_ref.get_sessionId(),
+            request_ref.get_path(),
+            request_ref.get_remote_ip()
+        );
 
-        endpoint->validator(request_ref);
-        endpoint->handler(request_ref, res);
+    endpoint->validator(request_ref);
+    return true;
+}
 
+// Turns an exception thrown by a validator or handler into the matching error response
+void server::io_worker::set_error_response(const http::request& request_ref, http::response& res, std::exception_ptr error) const {
+    using enum http::status;
+    try {
+        std::rethrow_exception(error);
     } catch (const validation::validation_error& e) {
         res.set_body(bad_request, std::format(R"({{"error":"{}"}})", e.what()));
     } catch (const sql::error& e) {
         util::log::error("SQL error in handler for path '{}': {}", request_ref.get_path(), e.what());
+        if (e.sqlstate == "HYT00" && util::deadline::expired()) {
+            res.set_body(gateway_timeout, R"({"error":"Request deadline exceeded"})");
+            return;
+        }
         res.set_body(internal_server_error, R"({"error":"Database operation failed"})");
     } catch (const json::parsing_error& e) {
         util::log::error("JSON parsing error in handler for path '{}': {}", request_ref.get_path(), e.what());
@@ -336,6 +528,10 @@ void server::io_worker::execute_handler(const http::request& request_ref, http::
         res.set_body(internal_server_error, R"({"error":"Failed to generate JSON response"})");
     } catch (const curl_exception& e) {
         util::log::error("HTTP client error in handler for path '{}': {}", request_ref.get_path(), e.what());
+        if (util::deadline::expired()) {
+            res.set_body(gateway_timeout, R"({"error":"Request deadline exceeded"})");
+            return;
+        }
         res.set_body(internal_server_error, R"({"error":"Internal communication failed"})");
     } catch (/* NOSONAR */ const std::exception& e) {
         util::log::error("Unhandled exception in handler for path '{}': {}", request_ref.get_path(), e.what());
@@ -343,52 +539,167 @@ void server::io_worker::execute_handler(const http::request& request_ref, http::
     }
 }
 
-void server::io_worker::dispatch_to_worker(int fd, uint64_t connection_id, http::request req, const api_endpoint* endpoint) {
-    auto req_ptr = std::make_shared<http::request>(std::move(req));
+// Root of a coroutine request: owns the request and its response until the handler finishes, on whichever
+// thread it resumes, then posts the response back to this I/O thread like a worker does
+async::detached server::io_worker::run_coroutine_handler(std::unique_ptr<worker_job> job) {
+    {
+        const auto start_time = std::chrono::high_resolution_clock::now();
+        const http::request& req = job->req;
+        const api_endpoint* endpoint = job->endpoint;
+        // Awaitables carry this ID to the threads that resume the handler; it points into the request
+        const util::log::request_id_scope rid_scope(req.get_header_value(http::header_id::x_request_id).value_or(""));
+
+        http::response res(req.get_header_value(http::header_id::origin));
+        std::exception_ptr error;
+        try {
+            if (admit_request(req, res, endpoint)) {
+                co_await endpoint->async_handler(req, res);
+            }
+        } catch (...) {
+            error = std::current_exception();
+        }
+        if (error) {
+            set_error_response(req, res, error);
+        }
 
-    try {
-        m_thread_pool->push_task([this, fd, connection_id, req_ptr, endpoint]() {
-            const std::string request_id_str(req_ptr->get_header_value("x-request-id").value_or(""));
+        const auto duration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start_time);
+        job->permit.release();
+        m_metrics->record_request_time(duration);
+        util::log::perf("Coroutine API handler for '{}' completed in {} microseconds.", req.get_path(), duration.count());
+        job->res = std::move(res);
+    } // the request's views are gone here
+    // The job, request and all, goes back to this I/O thread; the push must come before the count drops
+    m_response_queue->push(std::move(job));
+    m_coroutine_requests.fetch_sub(1, std::memory_order_release); // last use of this io_worker: it may be draining
+}
+
+// Runs a non-blocking handler on this I/O thread, skipping the thread pool and response queue round trip
+void server::io_worker::execute_inline(connection_state& conn, uint64_t sequence, const http::request& req, const api_endpoint* endpoint) const {
+    const auto start_time = std::chrono::high_resolution_clock::now();
+
+    http::response res(req.get_header_value(http::header_id::origin));
+    execute_handler(req, res, endpoint);
+    conn.deliver(sequence, std::move(res));
+
+    const auto duration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start_time);
+    m_metrics->record_request_time(duration);
+    util::log::perf("Inline API handler for '{}' executed in {} microseconds.", req.get_path(), duration.count());
+}
+
+// The endpoint's budget (or the server default), shortened by an X-Request-Timeout header in milliseconds
+util::deadline::clock::time_point server::io_worker::request_deadline(const http::request& req, const api_endpoint* endpoint,
+                                                                     util::deadline::clock::time_point admitted_at) const {
+    std::chrono::milliseconds budget = endpoint->timeout.count() > 0 ? endpoint->timeout : m_request_timeout;
+    if (const auto header = req.get_header_value(http::header_id::x_request_timeout)) {
+        long long ms = 0;
+        const auto [ptr, ec] = std::from_chars(header->data(), header->data() + header->size(), ms);
+        if (ec == std::errc{} && ms > 0 && (budget.count() == 0 || ms < budget.count())) {
+            budget = std::chrono::milliseconds(ms);
+        }
+    }
+    return budget.count() > 0 ? admitted_at + budget : util::deadline::clock::time_point::max();
+}
+
+void server::io_worker::dispatch_to_worker(connection_state& conn, uint64_t sequence, http::request req, const api_endpoint* endpoint,
+                                           limiter_permit permit) {
+    const auto admitted_at = permit.admitted_at();
+    const auto deadline = request_deadline(req, endpoint, admitted_at);
+    // DIRECT_WRITE: with no response ahead of it, the worker owns the socket until its response is back here
+    const int direct_fd = m_direct_write && !m_ring && !endpoint->async_handler && conn.pipeline.size() == 1 ? conn.fd : -1;
+    // The task owns the job; queued stays valid while the task is alive, even if the pool rejects it
+    auto job_ptr = std::make_unique<worker_job>(worker_job{std::move(req), endpoint, admitted_at, deadline, sequence, conn.slot, conn.generation,
+                                                           direct_fd, std::move(permit)});
+    worker_job* queued = job_ptr.get();
+
+    auto work = [this, job = std::move(job_ptr)]() mutable {
+        try {
+            const http::request& request = job->req;
+            const std::string request_id_str(request.get_header_value(http::header_id::x_request_id).value_or(""));
             const util::log::request_id_scope rid_scope(request_id_str);
 
-            util::log::debug("Dispatching request to worker thread {} for fd {}", req_ptr->get_path(), fd);
+            if (util::deadline::clock::now() >= job->deadline) {
+                // Nobody is waiting for this answer any more: shed it without running the handler
+                util::log::warn("Request for '{}' expired after {} ms in the queue.", request.get_path(),
+                    std::chrono::duration_cast<std::chrono::milliseconds>(util::deadline::clock::now() - job->admitted_at).count());
+                http::response res(request.get_header_value(http::header_id::origin));
+                res.set_body(http::status::service_unavailable, R"({"error":"Service Unavailable: Request deadline expired in queue"})");
+                if (job->direct_fd != -1) write_direct(job->direct_fd, res);
+                job->permit.release();
+                m_metrics->increment_expired_requests();
+                job->res = std::move(res);
+                m_response_queue->push(std::move(job)); // last use of the job: the reactor owns it now
+                return;
+            }
+
+            if (job->endpoint->async_handler) {
+                // Runs here until the handler first suspends, then this worker is free for the next task
+                m_coroutine_requests.fetch_add(1, std::memory_order_relaxed);
+                const util::deadline::scope deadline_scope(job->deadline);
+                run_coroutine_handler(std::move(job));
+                return;
+            }
+
+            const api_endpoint* target = job->endpoint;
+            util::log::debug("Dispatching request to worker thread {} for connection slot {}", request.get_path(), job->slot);
             
             const auto start_time = std::chrono::high_resolution_clock::now();
-            m_metrics->increment_active_threads();
             
             // Record task in metrics for /systasks, correlated via thread ID
             const auto tid = std::this_thread::get_id();
-            m_metrics->add_task(std::string(req_ptr->get_path()), req_ptr->get_user(), tid);
+            m_metrics->add_task(std::string(request.get_path()), request.get_user(), tid);
+            m_metrics->increment_active_threads(); // after add_task, which may throw: the count stays balanced
 
-            http::response res(req_ptr->get_header_value("Origin"));
+            http::response res(request.get_header_value(http::header_id::origin));
             
-            execute_handler(*req_ptr, res, endpoint);
+            {
+                // SQL and HTTP calls made by the handler give up when the deadline passes
+                const util::deadline::scope deadline_scope(job->deadline);
+                execute_handler(request, res, target);
+            }
             
             // Task finished, remove from metrics
             m_metrics->remove_task(tid);
+            m_metrics->decrement_active_threads();
 
             const auto duration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start_time);
-            
-            m_response_queue->push({fd, connection_id, std::move(res)});
+            util::log::perf("API handler for '{}' executed in {} microseconds.", request.get_path(), duration.count());
+
+            // Nothing below throws: once the response is on the socket, the catch must not answer again
+            if (job->direct_fd != -1) write_direct(job->direct_fd, res);
+            job->permit.release();
             m_metrics->record_request_time(duration);
-            m_metrics->decrement_active_threads();
+            job->res = std::move(res);
+            m_response_queue->push(std::move(job)); // last use of the job: the reactor owns it now
+        } catch (...) {
+            // The connection waits for this answer in order, and the limiter for its permit: give both back
+            if (job) {
+                util::log::error("Worker failed on request for '{}' before answering it", job->req.get_path());
+                http::response res(job->req.get_header_value(http::header_id::origin));
+                res.set_body(http::status::internal_server_error, R"({"error":"Internal Server Error"})");
+                if (job->direct_fd != -1) write_direct(job->direct_fd, res);
+                job->permit.release();
+                job->res = std::move(res);
+                m_response_queue->push(std::move(job));
+            }
+        }
+    };
+    // Per-request state belongs in worker_job: the capture list is kept far from the inline storage limit
+    static_assert(sizeof(work) <= dispatch_task::capacity / 2, "dispatch task captures: move per-request fields into worker_job");
+    dispatch_task task(std::move(work));
 
-            util::log::perf("API handler for '{}' executed in {} microseconds.", req_ptr->get_path(), duration.count());
-        });
+    thread_pool& pool = *m_pools[endpoint->pool_index];
+    try {
+        pool.push_task(std::move(task), endpoint->prio);
+        conn.worker_writes = direct_fd != -1;
     } catch (const queue_full_error&) {
         using enum http::status;
-        util::log::warn("Worker queue full. Dropping request for '{}' from {}", 
-                        req_ptr->get_path(), req_ptr->get_remote_ip());
+        util::log::warn("Worker queue of pool {} full. Dropping request for '{}' from {}", 
+                        pool.get_name(), queued->req.get_path(), queued->req.get_remote_ip());
         
-        http::response res(req_ptr->get_header_value("Origin"));
+        http::response res(queued->req.get_header_value(http::header_id::origin));
         res.set_body(service_unavailable, R"({"error":"Service Unavailable: Server Overloaded"})");
-        
-        try {
-            m_response_queue->push({fd, connection_id, std::move(res)});
-        } catch (const server_error& ex) {
-            util::log::error("Critical: Epoll failure for fd {}: {}. Closing connection.", fd, ex.what());
-            close_connection(fd);
-        }
+        conn.deliver(sequence, std::move(res));
+        queued->permit.cancel();
     }
 }
 
@@ -407,35 +718,57 @@ void server::io_worker::setup_listening_socket() {
     server_addr.sin_port = htons(m_port);
     if (bind(m_listening_fd, (sockaddr*)&server_addr, sizeof(server_addr)) == -1) throw server_error("Bind failed");
     if (listen(m_listening_fd, server::LISTEN_BACKLOG) == -1) throw server_error("Listen failed");
+}
 
-    m_epoll_fd = epoll_create1(0);
-    add_to_epoll(m_listening_fd, EPOLLIN);
+// Takes over a listening socket inherited from the server being upgraded; false if it is not bound to our port
+bool server::io_worker::adopt_listening_socket(int fd) {
+    sockaddr_in addr{};
+    socklen_t len = sizeof(addr);
+    if (getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len) == -1 // NOSONAR: sockaddr cast required by the API
+        || addr.sin_family != AF_INET || ntohs(addr.sin_port) != m_port) {
+        return false;
+    }
+    fcntl(fd, F_SETFL, O_NONBLOCK);
+    m_listening_fd = fd;
+    return true;
 }
 
-void server::io_worker::add_to_epoll(int fd, uint32_t events) const {
+void server::io_worker::setup_epoll() {
+    if (!m_ring) {
+        m_epoll_fd = epoll_create1(0);
+    }
+    watch_fd(m_listening_fd);
+    if (m_unix_fd != -1) {
+        watch_fd(m_unix_fd);
+    }
+}
+
+// key is the connection key, or the bare fd for the reactor's own fds
+void server::io_worker::add_to_epoll(int fd, uint32_t events, uint64_t key) const {
     epoll_event event{};
     event.events = events | EPOLLET | EPOLLRDHUP;
-    event.data.fd = fd;
+    event.data.u64 = key;
     if (epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, fd, &event) == -1 && errno != EEXIST) {
         throw server_error("epoll_ctl ADD failed");
     }
 }
 
-void server::io_worker::modify_epoll(int fd, uint32_t events) {
+void server::io_worker::modify_epoll(connection_state& conn, uint32_t events) {
+    const int fd = conn.fd;
     epoll_event ev{};
     ev.events = events | EPOLLET | EPOLLRDHUP;
-    ev.data.fd = fd;
+    ev.data.u64 = conn.key();
     
     if (epoll_ctl(m_epoll_fd, EPOLL_CTL_MOD, fd, &ev) == -1) {
         if (errno == ENOENT) {
             util::log::error("server::io_worker::modify_epoll -> fd {} not found: {}, adding it instead.", fd, util::str_error_cpp(errno));
             if (epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, fd, &ev) == -1) {
                 util::log::error("Fatal error adding fd {} to epoll: {}", fd, util::str_error_cpp(errno));
-                close_connection(fd);
+                close_connection(conn);
             }
         } else {
             util::log::error("Fatal error modifying epoll for fd {}: {}", fd, util::str_error_cpp(errno));
-            close_connection(fd);
+            close_connection(conn);
         }
     }
 }
@@ -446,27 +779,11 @@ void server::io_worker::remove_from_epoll(int fd) const {
     }
 }
 
-void server::io_worker::on_connect() {
+void server::io_worker::on_connect(int listening_fd) {
     while (true) {
         // Handle successful connection first to avoid nesting the error logic
-        if (int client_fd = accept4(m_listening_fd, nullptr, nullptr, SOCK_NONBLOCK); client_fd != -1) {
-            try {
-                std::string client_ip = util::get_peer_ip_ipv4(client_fd);
-                util::log::debug("Thread {} accepted new connection from {} on fd {}", std::this_thread::get_id(), client_ip, client_fd);
-                
-                auto& conn = m_connections.try_emplace(client_fd, std::move(client_ip)).first->second;
-                conn.connection_id = ++m_next_connection_id;
-                
-                m_timeout_list.push_back(client_fd);
-                conn.timeout_it = std::prev(m_timeout_list.end());
-                
-                add_to_epoll(client_fd, EPOLLIN | EPOLLONESHOT);
-                m_metrics->increment_connections();
-            } catch (const server_error& e) {
-                util::log::error("Failed to initialize connection for fd {}: {}", client_fd, e.what());
-                close(client_fd);
-                m_connections.erase(client_fd); 
-            }
+        if (int client_fd = accept4(listening_fd, nullptr, nullptr, SOCK_NONBLOCK); client_fd != -1) {
+            register_connection(client_fd, listening_fd);
             continue; // Loop again for the next pending connection
         }
         
@@ -485,82 +802,203 @@ void server::io_worker::on_connect() {
     }
 }
 
-void server::io_worker::touch_connection(connection_state& conn) {
-    conn.update_activity();
-    m_timeout_list.splice(m_timeout_list.end(), m_timeout_list, conn.timeout_it);
+void server::io_worker::register_connection(int client_fd, int listening_fd) {
+    connection_state* conn = nullptr;
+    try {
+        // A local proxy has no useful address; log which process it is instead
+        std::string client_ip = listening_fd == m_unix_fd ? util::get_peer_credentials(client_fd) : util::get_peer_ip_ipv4(client_fd);
+        util::log::debug("Thread {} accepted new connection from {} on fd {}", std::this_thread::get_id(), client_ip, client_fd);
+        
+        conn = &m_connections.open(client_fd, std::move(client_ip));
+        
+        if (m_ring) {
+            arm_recv(client_fd, *conn);
+        } else {
+            add_to_epoll(client_fd, EPOLLIN | EPOLLONESHOT, conn->key());
+            conn->armed_events = EPOLLIN;
+        }
+        update_deadline(*conn);
+        m_metrics->increment_connections();
+    } catch (const server_error& e) {
+        util::log::error("Failed to initialize connection for fd {}: {}", client_fd, e.what());
+        close(client_fd);
+        if (conn != nullptr) {
+            m_connections.close(*conn);
+        }
+    }
+}
+
+void server::io_worker::on_read(connection_state& conn) {
+    // A full pipeline leaves the bytes in the kernel until responses free a slot and rearm EPOLLIN
+    if (conn.close_after_write || conn.pipeline.size() >= m_pipeline_depth) {
+        return;
+    }
+    if (handle_socket_read(conn, conn.fd)) {
+        process_buffered_requests(conn.fd, conn);
+    }
 }
 
-void server::io_worker::on_read(int fd) {
-    if (auto it = m_connections.find(fd); it != m_connections.end()
-         && handle_socket_read(it->second, fd)) {
-        if (it->second.parser.eof()) {
-            process_request(fd);
-        } else {
-            modify_epoll(fd, EPOLLIN | EPOLLONESHOT);
+void server::io_worker::on_write(connection_state& conn) {
+    do_write(conn.fd, conn);
+}
+
+// One write of the ready head of the pipeline: sendfile for a file body whose header is already out,
+// otherwise a single writev coalescing consecutive ready responses. Each response contributes its header
+// block and its body as separate iovecs, so bodies are never copied; a file body ends the batch.
+ssize_t server::io_worker::write_ready(int fd, const connection_state& conn) {
+    if (const auto chunk = conn.pipeline.front()->pending_file()) {
+        off_t offset = chunk->offset;
+        const ssize_t sent = sendfile(fd, chunk->fd, &offset, chunk->length);
+        if (sent == 0) {
+            errno = EIO; // the file shrank below its advertised Content-Length
+            return -1;
         }
+        return sent;
     }
+
+    std::array<iovec, server::MAX_WRITE_IOVECS> iov;
+    size_t iov_count = 0;
+    for (const auto& slot : conn.pipeline) {
+        if (!slot.has_value() || iov_count + 2 > iov.size()) break;
+        for (const auto buf : slot->buffers()) {
+            if (buf.empty()) continue;
+            iov[iov_count++] = {const_cast<char*>(buf.data()), buf.size()}; // NOSONAR: writev takes non-const iov_base
+        }
+        if (slot->has_file()) break; // its body follows via sendfile once the header is out
+    }
+    return writev(fd, iov.data(), static_cast<int>(iov_count));
 }
 
-void server::io_worker::on_write(int fd) {
-    if (auto it = m_connections.find(fd); it != m_connections.end()) {
-        do_write(fd, it->second);
+// Worker side of DIRECT_WRITE: one non-blocking writev of the response, recording what the kernel took.
+// The rest, a file body, EAGAIN or an error is left to the reactor, which writes it or closes the connection.
+void server::io_worker::write_direct(int fd, http::response& res) noexcept {
+    if (res.has_file()) return; // sendfile is paced by EPOLLOUT on the reactor
+    std::array<iovec, 2> iov;
+    size_t iov_count = 0;
+    for (const auto buf : res.buffers()) {
+        if (buf.empty()) continue;
+        iov[iov_count++] = {const_cast<char*>(buf.data()), buf.size()}; // NOSONAR: writev takes non-const iov_base
+    }
+    if (const ssize_t sent = writev(fd, iov.data(), static_cast<int>(iov_count)); sent > 0) {
+        res.update_pos(static_cast<size_t>(sent));
     }
 }
 
+// Releases responses strictly in request order, resuming partial writes on the next EPOLLOUT
 void server::io_worker::do_write(int fd, connection_state& conn) {
-    if (!conn.response.has_value()) return;
-    
-    http::response& res = *conn.response;
-    
-    touch_connection(conn);
+    if (!conn.head_ready()) return;
+    if (m_ring) {
+        submit_sends(fd, conn);
+        return;
+    }
+
+    const auto status = flush_ready(fd, conn);
+    if (status == write_status::closed) return;
+    if (status == write_status::blocked) {
+        rearm_connection(fd, conn);
+        return;
+    }
+    // Freed pipeline slots may unblock requests already sitting in the read buffer
+    process_buffered_requests(fd, conn);
+}
 
-    while (res.available_size() > 0) {
-        ssize_t bytes_sent = write(fd, res.buffer().data(), res.buffer().size());
+// Writes the ready head of the pipeline until it runs out or the socket would block (epoll only).
+// The caller rearms the connection; closed means the connection is gone.
+server::io_worker::write_status server::io_worker::flush_ready(int fd, connection_state& conn) {
+    bool progressed = false;
+    while (conn.head_ready()) {
+        const ssize_t bytes_sent = write_ready(fd, conn);
         if (bytes_sent == -1) {
             if (errno == EAGAIN || errno == EWOULDBLOCK) {
                 util::log::debug("rearming epoll for writing fd: {}", fd);
-                modify_epoll(fd, EPOLLOUT | EPOLLONESHOT);
-                return;
+                conn.write_blocked = true;
+                update_deadline(conn, progressed);
+                return write_status::blocked;
             }
             util::log::error("write error on fd {}: {}", fd, util::str_error_cpp(errno));
-            close_connection(fd);
-            return;
+            close_connection(conn);
+            return write_status::closed;
         }
-        res.update_pos(bytes_sent);
+        conn.consume_written(static_cast<size_t>(bytes_sent));
+        progressed = true;
     }
+    conn.write_blocked = false;
 
-    if (res.available_size() == 0) {
-        if (conn.close_after_write) {
-            close_connection(fd);
-            return;
+    if (conn.ready_to_close()) {
+        close_connection(conn);
+        return write_status::closed;
+    }
+
+    util::log::debug("Ready responses fully sent on fd {}", fd);
+    return write_status::complete;
+}
+
+// Arms the one-shot interest matching the connection state: write while blocked, read while the pipeline has room
+void server::io_worker::rearm_connection(int fd, connection_state& conn) {
+    if (m_ring) {
+        // Writes need no arming under io_uring; only the multishot recv follows pipeline room
+        const bool want_read = !conn.close_after_write && conn.pipeline.size() < m_pipeline_depth;
+        const bool reading = (conn.armed_events & EPOLLIN) != 0;
+        if (want_read && !reading) {
+            arm_recv(fd, conn);
+        } else if (!want_read && reading && !conn.recv_cancelled) {
+            cancel_recv(conn);
         }
-        
-        conn.reset();
-        touch_connection(conn);
-        modify_epoll(fd, EPOLLIN | EPOLLONESHOT);
-        util::log::debug("Response fully sent on fd {}", fd);
+        return;
+    }
+
+    uint32_t events = 0;
+    if (conn.write_blocked) {
+        events |= EPOLLOUT;
+    }
+    if (!conn.close_after_write && conn.pipeline.size() < m_pipeline_depth) {
+        events |= EPOLLIN;
+    }
+    if (events != 0 && events != conn.armed_events) {
+        conn.armed_events = events;
+        modify_epoll(conn, events | EPOLLONESHOT);
     }
 }
 
-void server::io_worker::close_connection(int fd) {
-    remove_from_epoll(fd);
+void server::io_worker::close_connection(connection_state& conn) {
+    const int fd = conn.fd;
+    if (conn.worker_writes) {
+        // A worker may be writing to fd: closing it now could let a new connection reuse the number under
+        // that write. Hang up and stop watching it; the slot is freed when the worker's response comes back.
+        if (!conn.close_deferred) {
+            shutdown(fd, SHUT_RDWR);
+            remove_from_epoll(fd);
+            m_timers.cancel(conn.timer);
+            conn.timer = timing_wheel::npos;
+            conn.close_deferred = true;
+        }
+        return;
+    }
+    if (m_ring) {
+        // Completes any recv or send the kernel still holds for this socket
+        shutdown(fd, SHUT_RDWR);
+    } else if (!conn.close_deferred) {
+        remove_from_epoll(fd);
+    }
     close(fd);
-    if (auto it = m_connections.find(fd); it != m_connections.end()) {
-        m_timeout_list.erase(it->second.timeout_it);
-        m_connections.erase(it);
-        m_metrics->decrement_connections();
+    if (conn.sends_in_flight > 0) {
+        m_retired_sends.try_emplace(ring_tag(ring_op::send, conn.slot, conn.generation),
+                                    conn.sends_in_flight, std::move(conn.pipeline));
     }
+    m_timers.cancel(conn.timer);
+    m_connections.close(conn);
+    m_metrics->decrement_connections();
 }
 
 bool server::io_worker::handle_socket_read(connection_state& conn, int fd) {
-    touch_connection(conn);
-    
     while (true) {
         try {
-            auto buffer = conn.parser.get_buffer();
+            // An idle connection holds no buffer: read into the worker's scratch and attach one only if data arrived
+            const bool attached = conn.parser.attached();
+            auto buffer = attached ? conn.parser.get_buffer() : std::span<char>(m_read_scratch);
             if (buffer.empty()) {
                 util::log::error("Parser buffer full for fd {}", fd);
-                close_connection(fd);
+                close_connection(conn);
                 return false;
             }
             
@@ -568,20 +1006,29 @@ bool server::io_worker::handle_socket_read(connection_state& conn, int fd) {
             
             // Handle successful read first to prevent nested error trees
             if (bytes_read > 0) {
-                conn.parser.update_pos(bytes_read);
+                if (attached) {
+                    conn.parser.update_pos(bytes_read);
+                } else if (!ingest_received(fd, conn, {m_read_scratch.data(), static_cast<size_t>(bytes_read)})) {
+                    return false;
+                }
+                // A complete request is buffered: parse this batch before reading more. The rest stays in the
+                // kernel, which slows a heavy pipeliner down instead of filling MAX_REQUEST_SIZE; re-arming
+                // the one-shot interest once the pipeline has room reports the unread bytes again.
+                if (conn.parser.eof()) return true;
             } else {
                 // Flattened error and EOF handling (Max Depth: 3)
                 if (bytes_read == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
                     // Normal exit: socket read buffer is fully drained
-                } else if (bytes_read == 0 && conn.parser.eof()) {
+                } else if (bytes_read == 0 && (conn.parser.eof() || !conn.pipeline.empty())) {
+                    // Half-closed: answer what was already received, then close
                     conn.close_after_write = true;
                 } else if (bytes_read == -1) {
                     util::log::error("read error on fd {}: {}", fd, util::str_error_cpp(errno));
-                    close_connection(fd);
+                    close_connection(conn);
                     return false;
                 } else {
                     // Client hung up midway through an incomplete request or while idle.
-                    close_connection(fd);
+                    close_connection(conn);
                     return false;
                 }
                 
@@ -590,63 +1037,88 @@ bool server::io_worker::handle_socket_read(connection_state& conn, int fd) {
         } catch (const socket_buffer_error& e) {
             using enum http::status;
             util::log::warn("Socket buffer error on fd {} from IP {}: {}", fd, conn.remote_ip, e.what());
-            close_connection(fd);
+            close_connection(conn);
             return false; 
         } catch (/* NOSONAR */ const std::exception& e) {
             util::log::error("Unexpected exception during socket read on fd {}: {}", fd, e.what());
-            close_connection(fd);
+            close_connection(conn);
             return false;
         }
     }
     return true;
 }
 
-void server::io_worker::process_request(int fd) {
-    auto it = m_connections.find(fd);
-    if (it == m_connections.end()) return;
-    
-    connection_state& conn = it->second;
-    const uint64_t conn_id = conn.connection_id;
+// Parses every complete request already buffered, as long as the pipeline has room for it.
+// Responses produced on this thread (inline handlers, internal APIs, errors) are written once the
+// batch is parsed, in a loop rather than through do_write, since writing them may free room for more.
+void server::io_worker::process_buffered_requests(int fd, connection_state& conn) {
+    while (true) {
+        while (conn.pipeline.size() < m_pipeline_depth && conn.parser.has_data() && conn.parser.eof()) {
+            process_request(fd, conn);
+        }
+        conn.parser.compact();
+        if (m_ring || conn.write_blocked || !conn.head_ready()) break;
+        const auto status = flush_ready(fd, conn);
+        if (status == write_status::closed) return;
+        if (status == write_status::blocked) break;
+    }
+    if (m_ring && !submit_sends(fd, conn)) return;
+    update_deadline(conn);
+    rearm_connection(fd, conn); // last: a failed epoll_ctl closes the connection
+}
+
+void server::io_worker::process_request(int fd, connection_state& conn) {
+    const uint64_t sequence = conn.next_sequence++;
+    conn.pipeline.emplace_back();
+    ++conn.in_flight;
+    if (!m_running) {
+        conn.close_after_write = true; // draining: the last request on this connection
+    }
 
-    if (auto res = conn.parser.finalize(); !res.has_value()) {
+    // Bytes past this request belong to the next pipelined one and stay with the connection's parser
+    http::request_parser parser = conn.parser.take_request(&m_buffers);
+    if (auto res = parser.finalize(); !res.has_value()) {
         util::log::error("Failed to parse request on fd {} from IP {}: {}", fd, conn.remote_ip, res.error().what());
         http::response err_res;
         err_res.set_body(http::status::bad_request, R"({"error":"Bad Request"})");
         
+        // Nothing after a malformed request can be framed reliably, so discard it
+        conn.parser = http::request_parser{};
         conn.close_after_write = true;
-        m_response_queue->push({fd, conn_id, std::move(err_res)});
+        conn.deliver(sequence, std::move(err_res));
         return;
     }
 
-    http::request req(std::move(conn.parser), conn.remote_ip);
-    route_parsed_request(fd, conn_id, std::move(req));
+    http::request req(std::move(parser), conn.remote_ip);
+    route_parsed_request(conn, sequence, std::move(req));
 }
 
 // Extracted to fix SonarCloud Cognitive Complexity > 15
-void server::io_worker::route_parsed_request(int fd, uint64_t conn_id, http::request req) {
-    const std::string request_id_str(req.get_header_value("x-request-id").value_or(""));
+// Everything answered here is delivered straight into the pipeline; only worker_pool endpoints leave the thread.
+void server::io_worker::route_parsed_request(connection_state& conn, uint64_t sequence, http::request req) {
+    const std::string request_id_str(req.get_header_value(http::header_id::x_request_id).value_or(""));
     const util::log::request_id_scope rid_scope(request_id_str);    
 
-    if (!cors::is_origin_allowed(req.get_header_value("Origin"), m_allowed_origins)) {
+    if (!cors::is_origin_allowed(req.get_header_value(http::header_id::origin), m_allowed_origins)) {
         util::log::warn("CORS check failed for origin: {} for path '{}' from {}", 
-            req.get_header_value("Origin").value_or("N/A"), req.get_path(), req.get_remote_ip());
+            req.get_header_value(http::header_id::origin).value_or("N/A"), req.get_path(), req.get_remote_ip());
         http::response err_res;
         err_res.set_body(http::status::forbidden, R"({"error":"CORS origin not allowed"})");
-        m_response_queue->push({fd, conn_id, std::move(err_res)});
+        conn.deliver(sequence, std::move(err_res));
         return;
     }
 
-    http::response res(req.get_header_value("Origin"));
+    http::response res(req.get_header_value(http::header_id::origin));
 
     // Flattened routing logic via early returns to optimize SonarCloud complexity
     if (req.get_method() == http::method::options) {
         res.set_options();
-        m_response_queue->push({fd, conn_id, std::move(res)});
+        conn.deliver(sequence, std::move(res));
         return;
     } 
     
     if (handle_internal_api(req, res)) {
-        m_response_queue->push({fd, conn_id, std::move(res)});
+        conn.deliver(sequence, std::move(res));
         return;
     } 
     
@@ -654,16 +1126,29 @@ void server::io_worker::route_parsed_request(int fd, uint64_t conn_id, http::req
     if (!endpoint) {
         util::log::warn("BOT-ALERT No handler found for path '{}' from {}", req.get_path(), req.get_remote_ip());
         res.set_body(http::status::not_found, R"({"error":"Not Found"})");
-        m_response_queue->push({fd, conn_id, std::move(res)});
+        conn.deliver(sequence, std::move(res));
         return;
     } 
-    
-    // Flag the connection as executing to prevent it from timing out during heavy workloads
-    if (auto it = m_connections.find(fd); it != m_connections.end()) {
-        it->second.is_processing = true;
+    if (!endpoint->path_param.empty()) {
+        req.set_path_param(endpoint->path_param);
+    }
+
+    // Shed before queueing: past the endpoint's adaptive limit the request would only wait and time out
+    limiter_permit permit(endpoint->limiter.get(), util::deadline::clock::now());
+    if (!permit.admitted()) {
+        util::log::warn("Concurrency limit {} reached. Shedding request for '{}' from {}", 
+                        endpoint->limiter->limit(), req.get_path(), req.get_remote_ip());
+        res.set_body(http::status::service_unavailable, R"({"error":"Service Unavailable: Server Overloaded"})");
+        conn.deliver(sequence, std::move(res));
+        return;
+    }
+
+    if (endpoint->mode == execution::io_thread) {
+        execute_inline(conn, sequence, req, endpoint);
+        return;
     }
     
-    dispatch_to_worker(fd, conn_id, std::move(req), endpoint);
+    dispatch_to_worker(conn, sequence, std::move(req), endpoint, std::move(permit));
 }
 
 bool server::io_worker::handle_internal_api(const http::request& req, http::response& res) const {
@@ -677,6 +1162,14 @@ bool server::io_worker::handle_internal_api(const http::request& req, http::resp
         res.set_body(ok, m_metrics->to_prometheus(), "text/plain"); return true;
     }
     if (req.get_path() == "/ping") { res.set_body(ok, R"({"status":"OK"})"); return true; }
+    if (req.get_path() == "/ready") {
+        // For load balancer health checks: 503 asks to be taken out of rotation until the load drops
+        const auto load = m_metrics->load();
+        res.set_body(load.drain ? service_unavailable : ok,
+            std::format(R"({{"status":"{}","weight":{},"queue_fill":{:.3f},"busy_threads":{:.3f},"connections":{},"latency_ms":{:.3f}}})",
+                load.drain ? "DRAIN" : "READY", load.weight, load.queue_fill, load.busy_ratio, load.connections, load.latency_ms));
+        return true;
+    }
     if (req.get_path() == "/version") {
         if (!validate_bearer_token(req, "/version")) { res.set_body(bad_request, R"({"error":"Bad Request"})"); return true; }
         res.set_body(ok, std::format(R"({{"pod_name":"{}","version":"{}","build_info":"{}"}})", m_metrics->get_pod_name(), g_version, BUILD_INFO));
@@ -698,6 +1191,342 @@ bool server::io_worker::validate_bearer_token(const http::request& req, std::str
     return true;
 }
 
+// ===================================================================
+//         server::io_worker io_uring backend (IO_BACKEND=uring)
+// ===================================================================
+namespace {
+    constexpr uint32_t ring_tag_target(uint64_t user_data) noexcept {
+        return static_cast<uint32_t>((user_data >> 32) & 0xFFFFFF);
+    }
+}
+
+// user_data layout: op (8 bits) | target (24 bits) | generation (32 bits). The target is the connection
+// slot, or the fd for the reactor's own fds (generation 0); the generation rejects completions for a reused slot.
+uint64_t server::io_worker::ring_tag(ring_op op, uint32_t target, uint32_t generation) noexcept {
+    return (static_cast<uint64_t>(op) << 56)
+         | ((static_cast<uint64_t>(target) & 0xFFFFFF) << 32)
+         | generation;
+}
+
+connection_state* server::io_worker::find_ring_connection(uint64_t user_data) {
+    return m_connections.find(ring_tag_target(user_data), static_cast<uint32_t>(user_data));
+}
+
+void server::io_worker::run_io_ring() {
+    while (m_running) {
+        const int rc = m_ring->submit_and_wait(1);
+        if (rc < 0 && rc != -EINTR && rc != -EBUSY) {
+            util::log::error("io_uring_enter failed in worker {}: {}", std::this_thread::get_id(), util::str_error_cpp(-rc));
+            return;
+        }
+        m_ring->for_each_cqe([this](const io_uring_cqe& cqe) { handle_completion(cqe); });
+    }
+    drain_io_ring();
+}
+
+void server::io_worker::drain_io_ring() {
+    util::log::info("I/O worker thread shutting down. Draining pending responses...");
+
+    begin_drain();
+    const __kernel_timespec wait_timeout{.tv_sec = 0, .tv_nsec = 10'000'000};
+    while (draining()) {
+        process_response_queue();
+
+        const int rc = m_ring->submit_and_wait(1, &wait_timeout);
+        if (rc < 0 && rc != -EINTR && rc != -ETIME && rc != -EBUSY) {
+            util::log::error("io_uring_enter failed during drain in worker {}: {}", std::this_thread::get_id(), util::str_error_cpp(-rc));
+            break;
+        }
+        m_ring->for_each_cqe([this](const io_uring_cqe& cqe) { handle_completion(cqe); });
+    }
+    util::log::info("I/O worker thread drain complete.");
+}
+
+void server::io_worker::handle_completion(const io_uring_cqe& cqe) {
+    switch (static_cast<ring_op>(cqe.user_data >> 56)) {
+        using enum ring_op;
+        case accept:
+            on_ring_accept(cqe);
+            break;
+        case recv:
+            on_ring_recv(cqe);
+            break;
+        case send:
+            on_ring_send(cqe);
+            break;
+        case writable:
+            on_ring_writable(cqe);
+            break;
+        case poll: {
+            const auto fd = static_cast<int>(ring_tag_target(cqe.user_data));
+            if ((cqe.flags & IORING_CQE_F_MORE) == 0) {
+                arm_poll(fd); // the kernel may end a multishot poll at any time (e.g. CQ overflow)
+            }
+            if (fd == m_timer_fd) {
+                on_timer_tick();
+            } else if (fd == m_event_fd) {
+                on_response_ready();
+            }
+            break; // shutdown fd: only wakes the loop to check m_running
+        }
+        case cancel:
+            break;
+    }
+}
+
+void server::io_worker::arm_accept(int listening_fd) {
+    auto& sqe = m_ring->get_sqe();
+    sqe.opcode = IORING_OP_ACCEPT;
+    sqe.fd = listening_fd;
+    sqe.ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe.accept_flags = SOCK_NONBLOCK;
+    sqe.user_data = ring_tag(ring_op::accept, static_cast<uint32_t>(listening_fd), 0);
+    (listening_fd == m_unix_fd ? m_unix_accept_armed : m_accept_armed) = true;
+}
+
+void server::io_worker::arm_poll(int fd) {
+    auto& sqe = m_ring->get_sqe();
+    sqe.opcode = IORING_OP_POLL_ADD;
+    sqe.fd = fd;
+    sqe.poll32_events = POLLIN;
+    sqe.len = IORING_POLL_ADD_MULTI;
+    sqe.user_data = ring_tag(ring_op::poll, static_cast<uint32_t>(fd), 0);
+}
+
+void server::io_worker::arm_recv(int fd, connection_state& conn) {
+    auto& sqe = m_ring->get_sqe();
+    sqe.opcode = IORING_OP_RECV;
+    sqe.fd = fd;
+    sqe.ioprio = IORING_RECV_MULTISHOT;
+    sqe.flags = IOSQE_BUFFER_SELECT;
+    sqe.buf_group = m_recv_buffers->group_id();
+    sqe.user_data = ring_tag(ring_op::recv, conn.slot, conn.generation);
+    conn.armed_events |= EPOLLIN;
+}
+
+// Pauses reading while the pipeline is full; the recv completes with -ECANCELED and is rearmed later
+void server::io_worker::cancel_recv(connection_state& conn) {
+    auto& sqe = m_ring->get_sqe();
+    sqe.opcode = IORING_OP_ASYNC_CANCEL;
+    sqe.addr = ring_tag(ring_op::recv, conn.slot, conn.generation);
+    sqe.user_data = ring_tag(ring_op::cancel, conn.slot, conn.generation);
+    conn.recv_cancelled = true;
+}
+
+// Queues the ready head of the pipeline as linked sends (header block, then body, per response),
+// so the kernel writes them strictly in order. Only one chain is in flight per connection;
+// its completion submits the next one. Returns false if the connection had to be closed.
+bool server::io_worker::submit_sends(int fd, connection_state& conn) {
+    if (conn.sends_in_flight > 0) return true;
+    if (!send_file_chunks(fd, conn)) return false;
+    if (conn.sends_in_flight > 0) return true; // waiting for POLLOUT
+
+    std::array<std::span<const char>, server::MAX_WRITE_IOVECS> segments;
+    unsigned count = 0;
+    for (const auto& slot : conn.pipeline) {
+        if (!slot.has_value() || count + 2 > segments.size()) break;
+        for (const auto buf : slot->buffers()) {
+            if (!buf.empty()) segments[count++] = buf;
+        }
+        if (slot->has_file()) break; // its body follows via sendfile once the header is out
+    }
+    if (count == 0) return true;
+
+    m_ring->reserve(count);
+
+    io_uring_sqe* last = nullptr;
+    for (unsigned i = 0; i < count; ++i) {
+        const auto buf = segments[i];
+        auto& sqe = m_ring->get_sqe();
+        sqe.opcode = IORING_OP_SEND;
+        sqe.fd = fd;
+        sqe.addr = reinterpret_cast<uint64_t>(buf.data()); // NOSONAR: kernel ABI takes the pointer as u64
+        sqe.len = static_cast<uint32_t>(buf.size());
+        sqe.msg_flags = MSG_NOSIGNAL | MSG_WAITALL;
+        sqe.flags = IOSQE_IO_LINK;
+        sqe.user_data = ring_tag(ring_op::send, conn.slot, conn.generation);
+        last = &sqe;
+    }
+    if (last != nullptr) {
+        last->flags = 0; // chain ends here
+    }
+    conn.sends_in_flight = count;
+    update_deadline(conn);
+    return true;
+}
+
+// io_uring has no sendfile opcode: a file body at the head of the pipeline is streamed from the reactor
+// while the socket accepts data, and a one-shot POLLOUT (counted as an in-flight send) resumes it.
+// Returns false if the connection had to be closed.
+bool server::io_worker::send_file_chunks(int fd, connection_state& conn) {
+    bool progressed = false;
+    while (!conn.pipeline.empty() && conn.pipeline.front().has_value() && conn.pipeline.front()->pending_file()) {
+        const ssize_t bytes_sent = write_ready(fd, conn);
+        if (bytes_sent == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            arm_writable(fd, conn);
+            break;
+        }
+        if (bytes_sent == -1) {
+            util::log::error("write error on fd {}: {}", fd, util::str_error_cpp(errno));
+            close_connection(conn);
+            return false;
+        }
+        conn.consume_written(static_cast<size_t>(bytes_sent));
+        progressed = true;
+    }
+    if (progressed && conn.ready_to_close()) {
+        close_connection(conn);
+        return false;
+    }
+    if (progressed || conn.sends_in_flight > 0) {
+        update_deadline(conn, progressed);
+    }
+    return true;
+}
+
+void server::io_worker::arm_writable(int fd, connection_state& conn) {
+    auto& sqe = m_ring->get_sqe();
+    sqe.opcode = IORING_OP_POLL_ADD;
+    sqe.fd = fd;
+    sqe.poll32_events = POLLOUT;
+    sqe.user_data = ring_tag(ring_op::writable, conn.slot, conn.generation);
+    ++conn.sends_in_flight;
+}
+
+void server::io_worker::on_ring_accept(const io_uring_cqe& cqe) {
+    const auto listening_fd = static_cast<int>(ring_tag_target(cqe.user_data));
+    bool& armed = listening_fd == m_unix_fd ? m_unix_accept_armed : m_accept_armed;
+    if ((cqe.flags & IORING_CQE_F_MORE) == 0) {
+        armed = false;
+    }
+
+    // Flattened error handling, mirroring on_connect(); a connection accepted while draining is still served once
+    if (cqe.res >= 0) {
+        register_connection(cqe.res, listening_fd);
+    } else if (cqe.res == -EMFILE || cqe.res == -ENFILE) {
+        util::log::warn("accept failed: File descriptor limit reached (EMFILE/ENFILE). Halting accepts.");
+        arm_timer(timing_wheel::clock::now() + 1s); // on_timer_tick() rearms the accept
+        return;
+    } else if (cqe.res != -ECANCELED) {
+        util::log::error("accept failed: {}", util::str_error_cpp(-cqe.res));
+    }
+
+    if (!armed && m_running) {
+        arm_accept(listening_fd);
+    }
+}
+
+void server::io_worker::on_ring_recv(const io_uring_cqe& cqe) {
+    const bool has_buffer = (cqe.flags & IORING_CQE_F_BUFFER) != 0;
+    const auto bid = static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+
+    connection_state* conn = find_ring_connection(cqe.user_data);
+    if (conn != nullptr && (cqe.flags & IORING_CQE_F_MORE) == 0) {
+        conn->armed_events &= ~static_cast<uint32_t>(EPOLLIN);
+        conn->recv_cancelled = false;
+    }
+
+    bool alive = conn != nullptr;
+    if (alive && has_buffer && cqe.res > 0) {
+        alive = ingest_received(conn->fd, *conn, m_recv_buffers->view(bid, static_cast<size_t>(cqe.res)));
+    }
+    if (has_buffer) {
+        m_recv_buffers->recycle(bid);
+    }
+    if (!alive) return;
+
+    const int fd = conn->fd;
+    // Flattened error and EOF handling, mirroring handle_socket_read()
+    if (cqe.res == 0 && (conn->parser.eof() || !conn->pipeline.empty())) {
+        conn->close_after_write = true;
+    } else if (cqe.res == 0) {
+        close_connection(*conn);
+        return;
+    } else if (cqe.res < 0 && cqe.res != -ENOBUFS && cqe.res != -ECANCELED) {
+        util::log::error("read error on fd {}: {}", fd, util::str_error_cpp(-cqe.res));
+        close_connection(*conn);
+        return;
+    }
+
+    process_buffered_requests(fd, *conn);
+}
+
+// Copies received bytes into the connection's parser, attaching a pooled buffer first if it has none;
+// false if the connection had to be closed
+bool server::io_worker::ingest_received(int fd, connection_state& conn, std::string_view data) {
+    try {
+        conn.parser.attach(&m_buffers);
+        while (!data.empty()) {
+            auto buffer = conn.parser.get_buffer();
+            if (buffer.empty()) {
+                util::log::error("Parser buffer full for fd {}", fd);
+                close_connection(conn);
+                return false;
+            }
+            const size_t n = std::min(buffer.size(), data.size());
+            std::memcpy(buffer.data(), data.data(), n);
+            conn.parser.update_pos(static_cast<ssize_t>(n));
+            data.remove_prefix(n);
+        }
+    } catch (const socket_buffer_error& e) {
+        util::log::warn("Socket buffer error on fd {} from IP {}: {}", fd, conn.remote_ip, e.what());
+        close_connection(conn);
+        return false;
+    }
+    return true;
+}
+
+// Completion of a send or POLLOUT wait for a connection closed while it was in flight
+void server::io_worker::release_retired_send(uint64_t user_data) {
+    const uint64_t key = ring_tag(ring_op::send, ring_tag_target(user_data), static_cast<uint32_t>(user_data));
+    if (auto it = m_retired_sends.find(key); it != m_retired_sends.end() && --it->second.sends_in_flight == 0) {
+        m_retired_sends.erase(it);
+    }
+}
+
+void server::io_worker::on_ring_send(const io_uring_cqe& cqe) {
+    connection_state* conn = find_ring_connection(cqe.user_data);
+    if (conn == nullptr) {
+        release_retired_send(cqe.user_data);
+        return;
+    }
+
+    const int fd = conn->fd;
+    --conn->sends_in_flight;
+    if (cqe.res > 0) {
+        conn->consume_written(static_cast<size_t>(cqe.res));
+        update_deadline(*conn, true);
+    } else if (cqe.res < 0 && cqe.res != -ECANCELED) {
+        // -ECANCELED only marks the rest of a chain broken by a short send; it is resubmitted below
+        util::log::error("write error on fd {}: {}", fd, util::str_error_cpp(-cqe.res));
+        close_connection(*conn);
+        return;
+    }
+    if (conn->sends_in_flight > 0) return;
+
+    if (conn->ready_to_close()) {
+        close_connection(*conn);
+        return;
+    }
+    if (!submit_sends(fd, *conn)) return;
+    // Freed pipeline slots may unblock requests already sitting in the read buffer
+    process_buffered_requests(fd, *conn);
+}
+
+// The socket drained enough to resume a file body; socket errors surface on the next sendfile
+void server::io_worker::on_ring_writable(const io_uring_cqe& cqe) {
+    connection_state* conn = find_ring_connection(cqe.user_data);
+    if (conn == nullptr) {
+        release_retired_send(cqe.user_data);
+        return;
+    }
+
+    const int fd = conn->fd;
+    --conn->sends_in_flight;
+    if (!submit_sends(fd, *conn)) return;
+    process_buffered_requests(fd, *conn);
+}
+
 // ===================================================================
 //         server Implementation
 // ===================================================================
@@ -705,10 +1534,23 @@ server::server() {
     m_port = static_cast<uint16_t>(env::get<int>("PORT", 8080));
     m_io_threads = env::get<int>("IO_THREADS", std::thread::hardware_concurrency());
     m_worker_threads = env::get<int>("POOL_SIZE", 16);
+    m_max_worker_threads = std::max(m_worker_threads, env::get<int>("POOL_MAX_SIZE", m_worker_threads));
     m_queue_capacity = env::get<size_t>("QUEUE_CAPACITY", 1000uz);
+    m_affinity = affinity::parse_mode(env::get<std::string>("CPU_AFFINITY", "none"));
+    m_concurrency_limit = env::get<std::string>("CONCURRENCY_LIMIT", "adaptive") == "adaptive";
+    m_work_stealing = env::get<std::string>("WORK_STEALING", "on") != "off";
+    m_handler_usage = env::get<std::string>("HANDLER_USAGE", "on") != "off";
+    m_unix_path = env::get<std::string>("UNIX_SOCKET_PATH", "");
+    m_agent_port = static_cast<uint16_t>(env::get<int>("AGENT_CHECK_PORT", 0));
     
     m_signals = std::make_unique<util::signal_handler>();
     m_metrics = std::make_shared<metrics>(m_worker_threads);
+
+    m_binary_path = handoff::current_executable();
+    m_upgrade_channel = env::get<int>(handoff::SOCKET_ENV, -1);
+    if (m_upgrade_channel != -1) {
+        fcntl(m_upgrade_channel, F_SETFD, FD_CLOEXEC);
+    }
     
     const std::string origins_str = env::get<std::string>("CORS_ORIGINS", "");
     if (!origins_str.empty()) {
@@ -719,7 +1561,199 @@ server::server() {
     }
 }
 
-server::~server() noexcept = default;
+server::~server() noexcept {
+    // Idle workers may be running tasks stolen from a sibling pool: stop them all before any io_worker goes away
+    for (const auto& w : m_workers) {
+        w->stop_thread_pools();
+    }
+    if (m_unix_fd != -1) close(m_unix_fd);
+}
+
+void server::enable_concurrency_limits() {
+    concurrency_limiter::options opts;
+    // Below one request per worker thread a limit cannot protect anything; above workers plus queues the pool rejects anyway
+    const int queue_slots = m_queue_capacity == 0 ? m_worker_threads * 64 : static_cast<int>(m_queue_capacity) * m_io_threads;
+    opts.min_limit = std::max(1, env::get<int>("CONCURRENCY_LIMIT_MIN", m_worker_threads));
+    opts.max_limit = std::max(opts.min_limit, env::get<int>("CONCURRENCY_LIMIT_MAX", m_worker_threads + queue_slots));
+    opts.initial_limit = 2 * opts.min_limit; // about one service time of queueing
+
+    for (const auto& [path, limiter] : m_router.enable_concurrency_limits(opts)) {
+        m_metrics->register_limiter(path, limiter);
+    }
+    util::log::info("Adaptive concurrency limits enabled: between {} and {} requests in flight per endpoint.", 
+        opts.min_limit, opts.max_limit);
+}
+
+// Workers only steal from the pool of the same name in other I/O threads, so bulkheads stay apart
+void server::enable_work_stealing() {
+    const size_t pool_count = m_workers.front()->get_thread_pools().size();
+    for (size_t i = 0; i < pool_count; ++i) {
+        std::vector<thread_pool*> group;
+        group.reserve(m_workers.size());
+        for (const auto& w : m_workers) group.push_back(w->get_thread_pools()[i].get());
+        for (thread_pool* pool : group) pool->set_steal_group(group);
+    }
+    util::log::info("Work stealing enabled across {} I/O threads.", m_workers.size());
+}
+
+void server::add_worker_pool(std::string name, int threads, size_t queue_capacity, int max_threads) {
+    if (name.empty() || name == "default" 
+        || std::ranges::any_of(m_named_pools, [&name](const auto& p) { return p.name == name; })) {
+        throw server_error(std::format("Invalid or duplicate worker pool name: '{}'", name));
+    }
+    threads = std::max(1, threads);
+    m_named_pools.push_back({std::move(name), threads, queue_capacity, std::max(threads, max_threads)});
+}
+
+// The pools each I/O thread runs: the default pool, then the named pools, with their threads split between I/O threads
+std::vector<worker_pool_config> server::plan_worker_pools() {
+    std::vector<std::string> names;
+    names.reserve(m_named_pools.size());
+    for (const auto& p : m_named_pools) names.push_back(p.name);
+    if (const auto unknown = m_router.resolve_pools(names)) {
+        throw server_error(std::format("Endpoint assigned to undeclared worker pool '{}'", *unknown));
+    }
+
+    std::vector<worker_pool_config> pools;
+    pools.reserve(m_named_pools.size() + 1);
+    pools.push_back({"default", std::max(1, m_worker_threads / m_io_threads), m_queue_capacity,
+                     std::max(1, m_max_worker_threads / m_io_threads)});
+    for (const auto& p : m_named_pools) {
+        pools.push_back({p.name, std::max(1, p.threads / m_io_threads), p.queue_capacity == 0 ? m_queue_capacity : p.queue_capacity,
+                         std::max(1, p.max_threads / m_io_threads)});
+        util::log::info("Worker pool {} uses {} to {} threads per I/O thread.", p.name, pools.back().threads, pools.back().max_threads);
+    }
+    return pools;
+}
+
+// Listening fds passed by the server process being upgraded, in its worker order; empty on a normal start
+std::vector<int> server::receive_inherited_listeners() {
+    if (m_upgrade_channel == -1) return {};
+    try {
+        auto fds = handoff::receive_fds(m_upgrade_channel);
+        util::log::info("Took over {} listening socket(s) from the previous server process.", fds.size());
+        return fds;
+    } catch (const handoff::handoff_error& e) {
+        util::log::error("Listening socket handoff failed, binding new sockets: {}", e.what());
+        return {};
+    }
+}
+
+namespace {
+    // Path an AF_UNIX socket is bound to; nullopt for any other kind of socket
+    std::optional<std::string> unix_socket_path(int fd) {
+        sockaddr_un addr{};
+        socklen_t len = sizeof(addr);
+        if (getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len) == -1 || addr.sun_family != AF_UNIX) { // NOSONAR: sockaddr cast required by the API
+            return std::nullopt;
+        }
+        return std::string(addr.sun_path, strnlen(addr.sun_path, sizeof(addr.sun_path)));
+    }
+}
+
+// The optional AF_UNIX listener for proxies on the same host. It has no SO_REUSEPORT group, so one socket
+// is shared by all workers. After an upgrade the previous process's socket is adopted, keeping its queue.
+void server::setup_unix_listener(std::vector<int>& inherited) {
+    if (const auto it = std::ranges::find_if(inherited, [](int fd) { return unix_socket_path(fd).has_value(); }); it != inherited.end()) {
+        const int fd = *it;
+        inherited.erase(it);
+        if (!m_unix_path.empty() && unix_socket_path(fd) == m_unix_path) {
+            m_unix_fd = fd;
+        } else {
+            close(fd);
+        }
+    }
+
+    if (m_unix_fd == -1 && !m_unix_path.empty()) {
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        if (m_unix_path.size() >= sizeof(addr.sun_path)) throw server_error("UNIX_SOCKET_PATH is too long");
+        std::memcpy(addr.sun_path, m_unix_path.data(), m_unix_path.size());
+
+        // A socket file left by an earlier run makes bind fail; anything else at that path is not ours to remove
+        if (struct stat st{}; lstat(m_unix_path.c_str(), &st) == 0 && S_ISSOCK(st.st_mode)) {
+            unlink(m_unix_path.c_str());
+        }
+        m_unix_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (m_unix_fd == -1) throw server_error("Failed to create Unix socket");
+        if (bind(m_unix_fd, (sockaddr*)&addr, sizeof(addr)) == -1) throw server_error(std::format("Bind failed for {}", m_unix_path));
+
+        const std::string mode_str = env::get<std::string>("UNIX_SOCKET_MODE", "660");
+        mode_t mode = 0660;
+        std::from_chars(mode_str.data(), mode_str.data() + mode_str.size(), mode, 8);
+        chmod(m_unix_path.c_str(), mode);
+        if (listen(m_unix_fd, server::LISTEN_BACKLOG) == -1) throw server_error("Listen failed on the Unix socket");
+    }
+
+    if (m_unix_fd != -1) {
+        util::log::info("Also listening on Unix socket {}.", m_unix_path);
+        for (const auto& w : m_workers) w->set_unix_listening_fd(m_unix_fd);
+    }
+}
+
+// Listeners join the SO_REUSEPORT group in worker order, so group index i is worker i. After an upgrade
+// the workers adopt the previous process's sockets instead, which keeps their accept queues and group slots.
+void server::setup_listeners(const std::vector<affinity::placement>& placements) {
+    auto inherited = receive_inherited_listeners();
+    setup_unix_listener(inherited);
+    for (size_t i = 0; i < m_workers.size(); ++i) {
+        if (i < inherited.size() && m_workers[i]->adopt_listening_socket(inherited[i])) continue;
+        if (i < inherited.size()) {
+            util::log::warn("Inherited socket {} is not listening on port {}, binding a new one.", inherited[i], m_port);
+            close(inherited[i]);
+        }
+        m_workers[i]->setup_listening_socket();
+    }
+    if (inherited.size() > m_workers.size()) {
+        // Their queues keep filling until the previous process exits and the kernel resets them
+        util::log::warn("Closing {} inherited listening socket(s) beyond IO_THREADS={}; keep IO_THREADS unchanged across upgrades.", 
+            inherited.size() - m_workers.size(), m_io_threads);
+        for (size_t i = m_workers.size(); i < inherited.size(); ++i) close(inherited[i]);
+    }
+
+    const int group_fd = m_workers.front()->get_listening_fd();
+    if (m_affinity != affinity::mode::none && m_io_threads > 1 
+        && affinity::attach_reuseport_steering(group_fd, placements)) {
+        util::log::info("New connections are steered to the I/O worker owning the receiving CPU.");
+    } else if (!inherited.empty()) {
+        affinity::detach_reuseport_steering(group_fd);
+    }
+}
+
+/**
+ * @brief Upgrades the server in place on SIGUSR2.
+ * @details Starts the binary this process was launched from (normally a new build moved over it), with the
+ * same environment, and hands it the listening sockets. Once it reports ready this process stops accepting
+ * and drains; if it fails to start, it is killed and this process keeps serving.
+ * @return true if the new process took over.
+ */
+bool server::hand_over_listeners() {
+    util::log::info("Received SIGUSR2, handing the listening sockets over to a new {} process.", m_binary_path);
+    std::vector<int> fds;
+    fds.reserve(m_workers.size() + 1);
+    for (const auto& w : m_workers) fds.push_back(w->get_listening_fd());
+    if (m_unix_fd != -1) fds.push_back(m_unix_fd); // told apart by its address family on the other side
+
+    handoff::successor next;
+    try {
+        next = handoff::spawn(m_binary_path);
+        handoff::send_fds(next.channel, fds);
+    } catch (const handoff::handoff_error& e) {
+        util::log::error("Upgrade aborted, still serving: {}", e.what());
+        handoff::abandon(next);
+        return false;
+    }
+    if (!handoff::wait_ready(next.channel, UPGRADE_READY_TIMEOUT)) {
+        util::log::error("New server process {} exited or did not become ready within {}; upgrade aborted, still serving.", 
+            next.pid, UPGRADE_READY_TIMEOUT);
+        handoff::abandon(next);
+        handoff::notify_service_manager(std::format("MAINPID={}", getpid()));
+        return false;
+    }
+    close(next.channel);
+    util::log::info("New server process {} is accepting connections, shutting down.", next.pid);
+    return true;
+}
 
 void server::start() {
     auto setup_start = std::chrono::steady_clock::now();
@@ -730,18 +1764,45 @@ void server::start() {
     util::log::info("Using {} I/O threads and {} total worker threads.", 
         m_io_threads, m_worker_threads);
 
-    const int worker_threads_per_io = std::max(1, m_worker_threads / m_io_threads);
     std::vector<std::jthread> io_worker_threads;
     io_worker_threads.reserve(m_io_threads);
 
+    if (m_concurrency_limit) {
+        enable_concurrency_limits();
+    }
+    if (m_handler_usage) {
+        for (const auto& [path, usage] : m_router.enable_usage_accounting()) {
+            m_metrics->register_usage(path, usage);
+        }
+    }
+
+    const auto pools = plan_worker_pools();
+    auto placements = affinity::plan(m_affinity, m_io_threads);
     for (int i = 0; i < m_io_threads; ++i) {
+        if (placements[i].pinned()) {
+            util::log::info("I/O worker {} pinned to CPU {}, its worker pool to {} CPU(s).", 
+                i, placements[i].cpus.front(), placements[i].pool_cpus.size());
+        }
         auto worker = std::make_unique<io_worker>(
             m_port, m_metrics, m_router, m_allowed_origins, 
-            worker_threads_per_io, m_queue_capacity, m_running
+            pools, m_running, placements[i]
         );
-        m_metrics->register_thread_pool(worker->get_thread_pool());
+        for (const auto& pool : worker->get_thread_pools()) {
+            m_metrics->register_thread_pool(*pool);
+        }
         m_workers.push_back(std::move(worker));
     }
+    if (m_work_stealing && m_workers.size() > 1) {
+        enable_work_stealing();
+    }
+    if (m_router.has_coroutine_handlers()) {
+        m_metrics->register_thread_pool(async::blocking_pool());
+    }
+    setup_listeners(placements);
+    if (m_agent_port != 0) {
+        m_agent_check = std::make_unique<agent_check>(m_agent_port, m_metrics);
+        util::log::info("HAProxy agent-check listening on port {}.", m_agent_port);
+    }
 
     for (int i = 0; i < m_io_threads; ++i) {
         io_worker_threads.emplace_back([this, i] { m_workers[i]->run(); });
@@ -751,11 +1812,37 @@ void server::start() {
     auto setup_ms = std::chrono::duration_cast<std::chrono::microseconds>(setup_end - setup_start).count();
     util::log::info("Server started in {} microseconds.", setup_ms);
 
-    if (signalfd_siginfo ssi; read(m_signals->get_fd(), &ssi, sizeof(ssi)) == sizeof(ssi)) {
+    // Announced before the previous process exits, so systemd keeps the unit running with this one
+    handoff::notify_service_manager(std::format("MAINPID={}\nREADY=1", getpid()));
+    if (m_upgrade_channel != -1) {
+        handoff::signal_ready(m_upgrade_channel); // the previous process stops accepting and drains
+        close(m_upgrade_channel);
+        m_upgrade_channel = -1;
+    }
+
+    bool handed_over = false;
+    while (true) {
+        signalfd_siginfo ssi;
+        if (read(m_signals->get_fd(), &ssi, sizeof(ssi)) != sizeof(ssi)) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (ssi.ssi_signo == SIGUSR2) {
+            handed_over = hand_over_listeners();
+            if (handed_over) break;
+            continue;
+        }
         const char* signal_name = strsignal(ssi.ssi_signo);
         util::log::info("Received signal {} ({}), shutting down.", ssi.ssi_signo, signal_name ? signal_name : "Unknown");
+        break;
     }
     
+    if (handed_over) {
+        // The successor answers on the agent-check port now; a "drain" from here would drain it as well
+        m_agent_check.reset();
+    } else {
+        m_metrics->set_draining();
+    }
     m_running = false;
     for (const auto& w : m_workers) {
         // Wakes up epoll_wait instantly via dedicated shutdown fd
@@ -764,4 +1851,4 @@ void server::start() {
 
         w->get_response_queue()->stop(); 
     }
- }
\ No newline at end of file
+ }
\ No newline at end of file
@@ -10,8 +10,15 @@
 #include "api_router.hpp"
 #include "thread_pool.hpp"
 #include "shared_queue.hpp"
+#include "mpsc_queue.hpp"
 #include "util.hpp"
 #include "password.hpp"
+#include "io_ring.hpp"
+#include "timing_wheel.hpp"
+#include "cpu_affinity.hpp"
+#include "listener_handoff.hpp"
+#include "deadline.hpp"
+#include "agent_check.hpp"
 #include <sys/epoll.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
@@ -27,7 +34,8 @@
 #include <thread>
 #include <cstdint>
 #include <chrono>
-#include <list>
+#include <deque>
+#include <optional>
 
 inline constexpr auto g_version = "1.3.4";
 
@@ -35,45 +43,202 @@ inline constexpr std::string_view BUILD_INFO =
         "Build Date: " __DATE__ " " __TIME__ 
         " | GCC " __VERSION__;
 
-using dispatch_task = std::function<void()>;
-
 class server_error : public std::runtime_error {
 public:
     using std::runtime_error::runtime_error;
 };
 
+// A worker pool of each I/O thread; named pools isolate endpoints from each other (see worker_lane)
+struct worker_pool_config {
+    std::string name;
+    int threads;            // per I/O thread
+    size_t queue_capacity;  // shared by the priorities, 0 = thread_pool::DEFAULT_CAPACITY
+    int max_threads;        // per I/O thread; above threads the pool grows while its workers are blocked
+};
+
+// Which deadline currently guards a connection; requests being processed have none
+enum class deadline_kind : uint8_t { none, header, body, idle, write };
+
 struct connection_state {
-    explicit connection_state(std::string ip) 
-        : remote_ip(std::move(ip)), last_activity(std::chrono::steady_clock::now()) {}
-    connection_state() = default;
-    
     http::request_parser parser;
-    std::optional<http::response> response;
+    // One slot per outstanding pipelined request, in arrival order; filled as workers finish
+    std::deque<std::optional<http::response>> pipeline;
     std::string remote_ip;
-    std::chrono::steady_clock::time_point last_activity;
-    uint64_t connection_id{0};
-    std::list<int>::iterator timeout_it;
+    int fd{-1};                 // -1 while the slot is free
+    uint32_t slot{0};           // index in the owning connection_slab
+    uint32_t generation{0};     // advances each time the slot is reused
+    uint64_t next_sequence{0};  // sequence assigned to the next parsed request
+    uint64_t write_sequence{0}; // sequence of pipeline.front()
+    uint32_t in_flight{0};      // requests still waiting for a response
+    uint32_t armed_events{0};   // one-shot epoll interest (or multishot recv) currently armed
+    uint32_t sends_in_flight{0}; // io_uring: linked sends not yet completed
+    timing_wheel::timer_id timer{timing_wheel::npos};
+    deadline_kind deadline{deadline_kind::none};
     
     bool close_after_write{false}; 
-    bool is_processing{false};
+    bool write_blocked{false};
+    bool recv_cancelled{false}; // io_uring: cancel of the multishot recv already submitted
+    bool worker_writes{false};  // DIRECT_WRITE: the worker answering the head request may write to the socket
+    bool close_deferred{false}; // closed while a worker could still write: the fd is kept until its response is back
 
+    // Stores a response in its pipeline slot; false if the sequence is unknown (stale)
+    bool deliver(uint64_t sequence, http::response&& res) {
+        if (sequence < write_sequence || sequence - write_sequence >= pipeline.size()) {
+            return false;
+        }
+        auto& entry = pipeline[sequence - write_sequence];
+        if (entry.has_value()) {
+            return false;
+        }
+        entry = std::move(res);
+        --in_flight;
+        return true;
+    }
+
+    // True when the response at the head of the pipeline is ready to be written
+    [[nodiscard]] bool head_ready() const noexcept {
+        return !pipeline.empty() && pipeline.front().has_value();
+    }
+
+    // A half-closed connection is done once every response is out and no complete request is left unparsed
+    [[nodiscard]] bool ready_to_close() {
+        return close_after_write && pipeline.empty() && !(parser.has_data() && parser.eof());
+    }
+
+    // Advances the in-order write cursor past bytes accepted by the kernel
+    void consume_written(size_t bytes) noexcept {
+        while (!pipeline.empty() && pipeline.front().has_value()) {
+            auto& res = *pipeline.front();
+            const size_t n = std::min(bytes, res.available_size());
+            res.update_pos(n);
+            bytes -= n;
+            if (res.available_size() > 0) {
+                return;
+            }
+            pipeline.pop_front();
+            ++write_sequence;
+        }
+    }
+
+    // Packs slot and generation into one word (epoll data), so a stale event never reaches a reused slot
+    [[nodiscard]] uint64_t key() const noexcept {
+        return (static_cast<uint64_t>(generation) << 32) | slot;
+    }
+
+    // Returns a closed slot to its initial state, keeping the generation and any allocated capacity.
+    // The read buffer, if any, goes back to its pool.
     void reset() {
-        parser = http::request_parser{};
-        response.reset();
-        close_after_write = false; 
-        is_processing = false;
-        update_activity();
-    }    
+        if (parser.attached()) {
+            parser = http::request_parser{};
+        }
+        pipeline.clear();
+        remote_ip.clear();
+        fd = -1;
+        next_sequence = 0;
+        write_sequence = 0;
+        in_flight = 0;
+        armed_events = 0;
+        sends_in_flight = 0;
+        timer = timing_wheel::npos;
+        deadline = deadline_kind::none;
+        close_after_write = false;
+        write_blocked = false;
+        recv_cancelled = false;
+        worker_writes = false;
+        close_deferred = false;
+    }
+};
+
+/**
+ * @brief Per-reactor storage for connection_state, addressed by a dense slot index instead of hashing the fd.
+ *
+ * Slots live in fixed-size chunks that never move, so references stay valid while the slab grows,
+ * and a closed slot is recycled in place (most recently freed first, while it is still cache-warm).
+ * Events, completions and worker responses carry the slot together with its generation; a generation
+ * mismatch means they were addressed to an earlier connection and are dropped. Single-threaded by design.
+ */
+class connection_slab {
+public:
+    connection_state& open(int fd, std::string remote_ip) {
+        if (m_free.empty()) {
+            grow();
+        }
+        const uint32_t slot = m_free.back();
+        m_free.pop_back();
+        auto& conn = at(slot);
+        conn.fd = fd;
+        conn.slot = slot;
+        conn.remote_ip = std::move(remote_ip);
+        if (++conn.generation == 0) {
+            conn.generation = 1; // generation 0 tags the reactor's own fds
+        }
+        ++m_active;
+        return conn;
+    }
+
+    void close(connection_state& conn) {
+        conn.reset();
+        m_free.push_back(conn.slot);
+        --m_active;
+    }
+
+    [[nodiscard]] connection_state* find(uint32_t slot, uint32_t generation) noexcept {
+        if (slot >= m_chunks.size() * CHUNK_SIZE) return nullptr;
+        auto& conn = at(slot);
+        return conn.fd != -1 && conn.generation == generation ? &conn : nullptr;
+    }
+
+    [[nodiscard]] connection_state* find(uint64_t key) noexcept {
+        return find(static_cast<uint32_t>(key), static_cast<uint32_t>(key >> 32));
+    }
+
+    [[nodiscard]] size_t size() const noexcept { return m_active; }
 
-    void update_activity() {
-        last_activity = std::chrono::steady_clock::now();
+    // Visits every open connection; fn may close the one it is given
+    template<typename Fn>
+    void for_each(Fn&& fn) {
+        for (const auto& chunk : m_chunks) {
+            for (uint32_t i = 0; i < CHUNK_SIZE; ++i) {
+                if (chunk[i].fd != -1) fn(chunk[i]);
+            }
+        }
     }
+
+private:
+    static constexpr uint32_t CHUNK_SIZE{256};
+
+    [[nodiscard]] connection_state& at(uint32_t slot) noexcept {
+        return m_chunks[slot / CHUNK_SIZE][slot % CHUNK_SIZE];
+    }
+
+    void grow() {
+        const auto base = static_cast<uint32_t>(m_chunks.size() * CHUNK_SIZE);
+        m_chunks.push_back(std::make_unique<connection_state[]>(CHUNK_SIZE));
+        // Pushed in reverse so the lowest slots are handed out first
+        for (uint32_t i = CHUNK_SIZE; i > 0; --i) {
+            m_free.push_back(base + i - 1);
+        }
+    }
+
+    std::vector<std::unique_ptr<connection_state[]>> m_chunks;
+    std::vector<uint32_t> m_free;
+    size_t m_active{0};
 };
 
-struct response_item {
-    int client_fd;
-    uint64_t connection_id;
-    http::response res;
+// A request on its way to a worker, with what is needed to answer it; one allocation per request. The worker
+// fills in res and pushes the whole job back through the response queue, linked by next, so answering allocates nothing
+struct worker_job {
+    http::request req;
+    const api_endpoint* endpoint;
+    util::deadline::clock::time_point admitted_at;
+    util::deadline::clock::time_point deadline;
+    uint64_t sequence;
+    uint32_t slot;
+    uint32_t generation;
+    int direct_fd; // DIRECT_WRITE: the socket the worker writes to, or -1
+    limiter_permit permit;
+    http::response res{};
+    worker_job* next{nullptr}; // owned by mpsc_queue while queued
 };
 
 class server {
@@ -86,36 +251,83 @@ public:
     server(server&&) = delete;
     server& operator=(server&&) = delete;
 
-    template<typename Validator>
-    void register_api(webapi_path path, http::method method, const Validator& v, api_handler_func handler, bool is_secure = true) {
-        m_router.register_api(path, method, v, std::move(handler), is_secure);
+    // Handlers are functions of (request, response) or coroutines returning async::task<void>
+    template<typename Validator, api_handler Handler>
+    void register_api(webapi_path path, http::method method, const Validator& v, Handler&& handler, bool is_secure = true,
+                      execution mode = execution::worker_pool) {
+        m_router.register_api(path, method, v, std::forward<Handler>(handler), is_secure, mode);
+    }
+
+    template<api_handler Handler>
+    void register_api(webapi_path path, http::method method, Handler&& handler, bool is_secure = true,
+                      execution mode = execution::worker_pool) {
+        m_router.register_api(path, method, std::forward<Handler>(handler), is_secure, mode);
     }
 
-    void register_api(webapi_path path, http::method method, api_handler_func handler, bool is_secure = true) {
-        m_router.register_api(path, method, std::move(handler), is_secure);
+    template<typename Validator, api_handler Handler>
+    void register_api(webapi_path path, http::method method, const Validator& v, Handler&& handler, bool is_secure,
+                      worker_lane lane) {
+        m_router.register_api(path, method, v, std::forward<Handler>(handler), is_secure, lane);
     }
 
+    template<api_handler Handler>
+    void register_api(webapi_path path, http::method method, Handler&& handler, bool is_secure, worker_lane lane) {
+        m_router.register_api(path, method, std::forward<Handler>(handler), is_secure, lane);
+    }
+
+    /**
+     * @brief Declares a named worker pool that endpoints can be assigned to with worker_lane.
+     * @param name The pool name used in register_api() and in metrics.
+     * @param threads Total worker threads, divided between the I/O threads like POOL_SIZE (at least one each).
+     * @param queue_capacity Queue slots per I/O thread, shared by the priorities; 0 uses QUEUE_CAPACITY.
+     * @param max_threads Total threads the pool may grow to while its workers are blocked; 0 keeps it at threads.
+     * @throws server_error if the name is empty, "default" or already declared.
+     */
+    void add_worker_pool(std::string name, int threads, size_t queue_capacity = 0, int max_threads = 0);
+
     void start();
 
 private:
+    void enable_concurrency_limits();
+    void enable_work_stealing();
+    [[nodiscard]] std::vector<worker_pool_config> plan_worker_pools();
+    [[nodiscard]] std::vector<int> receive_inherited_listeners();
+    void setup_listeners(const std::vector<affinity::placement>& placements);
+    void setup_unix_listener(std::vector<int>& inherited);
+    [[nodiscard]] bool hand_over_listeners();
+
     class io_worker {
     public:
         io_worker(uint16_t port,
                     std::shared_ptr<metrics> metrics, 
                     const api_router& router,
                     const std::unordered_set<std::string, util::string_hash, util::string_equal>& allowed_origins,
-                    int worker_thread_count,
-                    size_t queue_capacity,
-                    std::atomic<bool>& running_flag);
+                    const std::vector<worker_pool_config>& pools,
+                    std::atomic<bool>& running_flag,
+                    affinity::placement placement);
         
         ~io_worker() noexcept;
+        void setup_listening_socket();
+        [[nodiscard]] bool adopt_listening_socket(int fd);
+        // Shared by all workers and owned by the server; each worker accepts from it with EPOLLEXCLUSIVE
+        void set_unix_listening_fd(int fd) noexcept { m_unix_fd = fd; }
         void run();
 
-        [[nodiscard]] const thread_pool& get_thread_pool() const {
-            return *m_thread_pool;
+        [[nodiscard]] int get_listening_fd() const noexcept {
+            return m_listening_fd;
+        }
+
+        // Index 0 is the default pool, then the named pools in declaration order
+        [[nodiscard]] const std::vector<std::unique_ptr<thread_pool>>& get_thread_pools() const noexcept {
+            return m_pools;
         }
 
-        [[nodiscard]] shared_queue<response_item, true>* get_response_queue() const {
+        // Joins the pools' workers; with work stealing every pool must be stopped before any worker is destroyed
+        void stop_thread_pools() {
+            for (const auto& pool : m_pools) pool->stop();
+        }
+
+        [[nodiscard]] mpsc_queue<worker_job>* get_response_queue() const {
             return m_response_queue.get();
         }
 
@@ -124,40 +336,91 @@ private:
         }
 
     private:
-        void setup_listening_socket();
+        // io_uring completion tags, packed into the top byte of user_data
+        enum class ring_op : uint8_t { accept = 1, recv, send, poll, cancel, writable };
+
+        // Pending sends of a closed connection: their buffers must outlive the kernel's use of them
+        struct retired_sends {
+            uint32_t sends_in_flight;
+            std::deque<std::optional<http::response>> pipeline;
+        };
+
+        void setup_epoll();
         void setup_timerfd();
         void setup_eventfd();
         void setup_shutdown_fd();
+        void setup_io_ring();
+        void watch_fd(int fd);
         
-        void add_to_epoll(int fd, uint32_t events) const;
+        void add_to_epoll(int fd, uint32_t events, uint64_t key) const;
         void remove_from_epoll(int fd) const;
-        void modify_epoll(int fd, uint32_t events);
+        void modify_epoll(connection_state& conn, uint32_t events);
 
         void handle_epoll_event(const epoll_event& event);
-        void on_connect();
-        void on_read(int fd);
-        void on_write(int fd);
+        void run_epoll();
+        void on_connect(int listening_fd);
+        void register_connection(int client_fd, int listening_fd);
+        void on_read(connection_state& conn);
+        void on_write(connection_state& conn);
         void do_write(int fd, connection_state& conn);
-        void touch_connection(connection_state& conn);
+        enum class write_status { complete, blocked, closed };
+        write_status flush_ready(int fd, connection_state& conn);
+        [[nodiscard]] static ssize_t write_ready(int fd, const connection_state& conn);
+        static void write_direct(int fd, http::response& res) noexcept;
+        void rearm_connection(int fd, connection_state& conn);
+        void update_deadline(connection_state& conn, bool write_progress = false);
+        [[nodiscard]] std::chrono::seconds timeout_for(deadline_kind kind) const noexcept;
+        void arm_timer(timing_wheel::clock::time_point when);
         void on_timer_tick();
         void on_response_ready();
         
-        void close_connection(int fd);
+        void close_connection(connection_state& conn);
         void check_timeouts(); 
         void drain_pending_responses();
+        void begin_drain();
+        [[nodiscard]] bool draining() const;
+        [[nodiscard]] size_t unfinished_tasks() const;
+
+        void run_io_ring();
+        void drain_io_ring();
+        void handle_completion(const io_uring_cqe& cqe);
+        void arm_accept(int listening_fd);
+        void arm_poll(int fd);
+        void arm_recv(int fd, connection_state& conn);
+        void cancel_recv(connection_state& conn);
+        bool submit_sends(int fd, connection_state& conn);
+        bool send_file_chunks(int fd, connection_state& conn);
+        void arm_writable(int fd, connection_state& conn);
+        void on_ring_accept(const io_uring_cqe& cqe);
+        void on_ring_recv(const io_uring_cqe& cqe);
+        void on_ring_send(const io_uring_cqe& cqe);
+        void on_ring_writable(const io_uring_cqe& cqe);
+        void release_retired_send(uint64_t user_data);
+        bool ingest_received(int fd, connection_state& conn, std::string_view data);
+        [[nodiscard]] connection_state* find_ring_connection(uint64_t user_data);
+        [[nodiscard]] static uint64_t ring_tag(ring_op op, uint32_t target, uint32_t generation) noexcept;
 
         bool handle_socket_read(connection_state& conn, int fd);
-        void process_request(int fd);
-        void route_parsed_request(int fd, uint64_t conn_id, http::request req);
-        void dispatch_to_worker(int fd, uint64_t connection_id, http::request req, const api_endpoint* endpoint);
+        void process_buffered_requests(int fd, connection_state& conn);
+        void process_request(int fd, connection_state& conn);
+        void route_parsed_request(connection_state& conn, uint64_t sequence, http::request req);
+        void execute_inline(connection_state& conn, uint64_t sequence, const http::request& req, const api_endpoint* endpoint) const;
+        [[nodiscard]] util::deadline::clock::time_point request_deadline(const http::request& req, const api_endpoint* endpoint,
+                                                                         util::deadline::clock::time_point admitted_at) const;
+        void dispatch_to_worker(connection_state& conn, uint64_t sequence, http::request req, const api_endpoint* endpoint, limiter_permit permit);
         void process_response_queue();
+        void write_delivered(connection_state& conn);
         
         bool validate_bearer_token(const http::request& req, std::string_view path) const;
         bool handle_internal_api(const http::request& req, http::response& res) const;
         void execute_handler(const http::request& req, http::response& res, const api_endpoint* endpoint) const;
+        [[nodiscard]] bool admit_request(const http::request& req, http::response& res, const api_endpoint* endpoint) const;
+        void set_error_response(const http::request& req, http::response& res, std::exception_ptr error) const;
+        async::detached run_coroutine_handler(std::unique_ptr<worker_job> job);
         [[nodiscard]] bool validate_token(const http::request& req) const;
 
         int m_listening_fd{-1};
+        int m_unix_fd{-1};      // optional AF_UNIX listener (UNIX_SOCKET_PATH), not owned
         int m_epoll_fd{-1};
         int m_timer_fd{-1};
         int m_event_fd{-1}; 
@@ -168,24 +431,56 @@ private:
         const api_router& m_router;
         const std::unordered_set<std::string, util::string_hash, util::string_equal>& m_allowed_origins;
         std::atomic<bool>& m_running;
-        uint64_t m_next_connection_id{0};
+        affinity::placement m_placement;
+        size_t m_pipeline_depth;
+        bool m_use_io_ring{false};
+        bool m_direct_write{false}; // DIRECT_WRITE: workers write the response they produced when the socket is theirs
+        bool m_accept_armed{false};
+        bool m_unix_accept_armed{false};
+
+        // Declared before everything that may hold one of its buffers (parsers, queued requests)
+        buffer_pool m_buffers;
+        std::vector<char> m_read_scratch = std::vector<char>(server::READ_SCRATCH_SIZE);
         
-        std::unique_ptr<shared_queue<response_item, true>> m_response_queue; 
-        std::unique_ptr<thread_pool> m_thread_pool;
+        std::unique_ptr<mpsc_queue<worker_job>> m_response_queue;
+        std::vector<std::unique_ptr<thread_pool>> m_pools; // indexed by api_endpoint::pool_index
+        std::atomic<size_t> m_coroutine_requests{0};       // coroutine handlers started and not finished
 
-        std::unordered_map<int, connection_state> m_connections;
-        std::list<int> m_timeout_list;
+        connection_slab m_connections;
+        timing_wheel m_timers{server::TIMER_RESOLUTION};
+        timing_wheel::clock::time_point m_timer_armed_at{timing_wheel::clock::time_point::max()};
+        timing_wheel::clock::time_point m_drain_deadline{};
+        std::chrono::seconds m_header_timeout;
+        std::chrono::seconds m_body_timeout;
+        std::chrono::seconds m_idle_timeout;
+        std::chrono::seconds m_write_timeout;
+        std::chrono::milliseconds m_request_timeout; // default budget of worker pool requests, 0 = none
+        // Declared before m_ring so the buffers the kernel may still reference are released after it
+        std::unordered_map<uint64_t, retired_sends> m_retired_sends;
+        std::unique_ptr<provided_buffer_ring> m_recv_buffers;
+        std::unique_ptr<io_ring> m_ring;
         std::string m_api_key;
         std::string m_mfa_uri;        
     };
 
     static inline constexpr int MAX_EVENTS{8192};
+    static inline constexpr size_t MAX_WRITE_IOVECS{64};
+    static inline constexpr unsigned RING_ENTRIES{4096};
+    static inline constexpr uint16_t RING_RECV_BUFFERS{256};
+    static inline constexpr uint32_t RING_RECV_BUFFER_SIZE{16384};
+    static inline constexpr size_t READ_SCRATCH_SIZE{16384};
     static inline constexpr int LISTEN_BACKLOG{65536};
-    static inline constexpr std::chrono::seconds READ_TIMEOUT{60}; 
+    static inline constexpr std::chrono::milliseconds TIMER_RESOLUTION{100};
+    static inline constexpr std::chrono::seconds UPGRADE_READY_TIMEOUT{30};
 
     uint16_t m_port;
     int m_io_threads;
     int m_worker_threads;
+    int m_max_worker_threads;   // POOL_MAX_SIZE
+    affinity::mode m_affinity{affinity::mode::none};
+    bool m_concurrency_limit{true};
+    bool m_work_stealing{true};
+    bool m_handler_usage{true}; // HANDLER_USAGE: per-endpoint CPU time and context switches
     
     std::unique_ptr<util::signal_handler> m_signals;
     std::shared_ptr<metrics> m_metrics;
@@ -194,6 +489,13 @@ private:
     std::vector<std::unique_ptr<io_worker>> m_workers;
     std::atomic<bool> m_running{true};
     size_t m_queue_capacity{1000};
+    std::vector<worker_pool_config> m_named_pools; // total threads, from add_worker_pool()
+    std::string m_unix_path;    // UNIX_SOCKET_PATH: also listen on this AF_UNIX socket, for co-located proxies
+    int m_unix_fd{-1};
+    std::string m_binary_path;  // resolved at startup: the file replaced on disk is what an upgrade execs
+    int m_upgrade_channel{-1};  // set when started by a running server handing over its listeners
+    uint16_t m_agent_port{0};   // AGENT_CHECK_PORT: HAProxy agent-check responder, 0 = off
+    std::unique_ptr<agent_check> m_agent_check; // kept through a shutdown drain, so HAProxy hears "drain"; closed after an upgrade
 };
 
-#endif // SERVER_HPP
\ No newline at end of file
+#endif // SERVER_HPP
\ No newline at end of file
@@ -27,12 +27,13 @@ public:
         //    instead of terminating the process. This is standard practice for network servers.
         signal(SIGPIPE, SIG_IGN);
 
-        // 2. Block shutdown signals so they can be handled via signalfd.
+        // 2. Block shutdown and upgrade signals so they can be handled via signalfd.
         sigset_t mask;
         sigemptyset(&mask);
         sigaddset(&mask, SIGINT);
         sigaddset(&mask, SIGTERM);
         sigaddset(&mask, SIGQUIT);
+        sigaddset(&mask, SIGUSR2); // hands the listening sockets to a new binary (see listener_handoff.hpp)
 
         if (sigprocmask(SIG_BLOCK, &mask, nullptr) == -1) {
             throw signal_error("Failed to set sigprocmask");
@@ -2,13 +2,15 @@
 #define SOCKET_BUFFER_HPP
 
 #include "env.hpp"
+#include "buffer_pool.hpp"
 
 #include <stdexcept>
 #include <string>
-#include <vector>
+#include <memory>
 #include <string_view>
 #include <sys/types.h> // For ssize_t
 #include <algorithm>   // For std::min
+#include <cstring>     // For std::memcpy
 #include <span>        // For std::span
 #include <format>      // For std::format
 
@@ -17,62 +19,189 @@ public:
     using std::runtime_error::runtime_error;
 };
 
+/**
+ * @brief Growable read buffer for one request.
+ *
+ * Starts detached, without storage. Once attached it holds one block from a buffer_pool (or the heap
+ * if there is none); a request outgrowing the block moves to a private heap allocation and the block
+ * goes back to the pool. Moving keeps the data in place, so views into it stay valid.
+ * Bytes at the front can be consumed once a pipelined request has been taken out; they are reclaimed
+ * by compact(), or before the buffer grows.
+ */
 class socket_buffer {
 public:
     socket_buffer() = default;
-    
+
+    explicit socket_buffer(buffer_pool* pool) {
+        attach(pool);
+    }
+
+    // Seeds the buffer with bytes already read from the socket (e.g. the next pipelined request)
+    socket_buffer(std::string_view initial, buffer_pool* pool) {
+        attach(pool);
+        const size_t max_size = get_max_size();
+        size_t new_size = m_capacity;
+        while (initial.size() * 4 > new_size * 3 && new_size < max_size) {
+            new_size = std::min(new_size * 2, max_size);
+        }
+        if (initial.size() > new_size) {
+            throw socket_buffer_error(std::format("Maximum buffer size reached: {} bytes.", max_size));
+        }
+        grow(new_size);
+        std::memcpy(m_data, initial.data(), initial.size());
+        m_pos = initial.size();
+    }
+
+    ~socket_buffer() noexcept {
+        release_block();
+    }
+
+    socket_buffer(const socket_buffer&) = delete;
+    socket_buffer& operator=(const socket_buffer&) = delete;
+
+    socket_buffer(socket_buffer&& other) noexcept
+        : m_pool(other.m_pool), m_block(other.m_block), m_heap(std::move(other.m_heap)),
+          m_data(other.m_data), m_capacity(other.m_capacity), m_begin(other.m_begin), m_pos(other.m_pos) {
+        other.detach();
+    }
+
+    socket_buffer& operator=(socket_buffer&& other) noexcept {
+        if (this != &other) {
+            release_block();
+            m_pool = other.m_pool;
+            m_block = other.m_block;
+            m_heap = std::move(other.m_heap);
+            m_data = other.m_data;
+            m_capacity = other.m_capacity;
+            m_begin = other.m_begin;
+            m_pos = other.m_pos;
+            other.detach();
+        }
+        return *this;
+    }
+
+    // Gives a detached buffer its first block; a null pool allocates it on the heap
+    void attach(buffer_pool* pool) {
+        if (attached()) return;
+        m_pool = pool;
+        if (pool != nullptr) {
+            m_block = pool->acquire();
+            m_data = m_block;
+        } else {
+            m_heap = std::make_unique_for_overwrite<char[]>(k_chunk_size);
+            m_data = m_heap.get();
+        }
+        m_capacity = k_chunk_size;
+    }
+
+    [[nodiscard]] bool attached() const noexcept {
+        return m_capacity != 0;
+    }
+
     void update_pos(ssize_t n) {
         if (n <= 0) return;
 
         m_pos += static_cast<size_t>(n);
 
-        if (m_pos * 4 > m_buffer.size() * 3) {
+        if (m_pos * 4 > m_capacity * 3) {
+            compact();
+        }
+        if (m_pos * 4 > m_capacity * 3) {
             const size_t max_size = get_max_size();
 
-            if (m_buffer.size() >= max_size) {
+            if (m_capacity >= max_size) {
                 throw socket_buffer_error(std::format("Maximum buffer size reached: {} bytes.", max_size));
             }
             // Use geometric growth (2x) to prevent O(N^2) memory reallocation performance drops
-            size_t new_size = m_buffer.size() * 2;
-            m_buffer.resize(std::min(new_size, max_size));
+            grow(std::min(m_capacity * 2, max_size));
         }
     }
-    
+
     [[nodiscard]] std::span<char> buffer() noexcept {
-        return {m_buffer.data() + m_pos, available_size()};
+        return {m_data + m_pos, available_size()};
     }
 
     [[nodiscard]] size_t available_size() const noexcept {
-        return m_buffer.size() - m_pos;
+        return m_capacity - m_pos;
     }
 
     [[nodiscard]] bool empty() const noexcept {
-        return m_pos == 0;
+        return m_pos == m_begin;
     }
 
     [[nodiscard]] size_t buffer_size() const noexcept {
-        return m_buffer.size();
+        return m_capacity;
     }
 
     [[nodiscard]] size_t size() const noexcept {
-        return m_pos;
+        return m_pos - m_begin;
     }
-    
+
     [[nodiscard]] std::string_view view() const noexcept {
-        return {m_buffer.data(), m_pos};
+        return {m_data + m_begin, m_pos - m_begin};
+    }
+
+    // Drops the first n bytes of view(); an emptied buffer starts over at the front
+    void consume(size_t n) noexcept {
+        m_begin += std::min(n, size());
+        if (m_begin == m_pos) {
+            m_begin = 0;
+            m_pos = 0;
+        }
+    }
+
+    // Moves the unconsumed bytes to the front, invalidating views into them
+    void compact() noexcept {
+        if (m_begin == 0) return;
+        std::memmove(m_data, m_data + m_begin, size());
+        m_pos -= m_begin;
+        m_begin = 0;
     }
 
-private:
-    constexpr static size_t k_chunk_size{4096};
-    
     // Helper to retrieve max size from env, cached statically to avoid repeated lookups
     static size_t get_max_size() {
         static const size_t k_max_size = env::get<size_t>("MAX_REQUEST_SIZE", 5 * 1024 * 1024);
         return k_max_size;
     }
-    
-    std::vector<char> m_buffer = std::vector<char>(k_chunk_size, 0);
+
+private:
+    constexpr static size_t k_chunk_size{buffer_pool::BLOCK_SIZE};
+
+    // Moves the contents to a heap allocation of new_size bytes, returning the pool block if there was one
+    void grow(size_t new_size) {
+        if (new_size <= m_capacity) return;
+        auto heap = std::make_unique_for_overwrite<char[]>(new_size);
+        std::memcpy(heap.get(), m_data + m_begin, size());
+        release_block();
+        m_heap = std::move(heap);
+        m_data = m_heap.get();
+        m_capacity = new_size;
+        m_pos = size();
+        m_begin = 0;
+    }
+
+    void release_block() noexcept {
+        if (m_block != nullptr) {
+            m_pool->release(m_block);
+            m_block = nullptr;
+        }
+    }
+
+    void detach() noexcept {
+        m_block = nullptr;
+        m_data = nullptr;
+        m_capacity = 0;
+        m_begin = 0;
+        m_pos = 0;
+    }
+
+    buffer_pool* m_pool{nullptr};
+    char* m_block{nullptr};          // pool block, while the contents fit in it
+    std::unique_ptr<char[]> m_heap;  // otherwise
+    char* m_data{nullptr};
+    size_t m_capacity{0};
+    size_t m_begin{0};               // consumed bytes before view()
     size_t m_pos{0};
 };
 
-#endif // SOCKET_BUFFER_HPP
\ No newline at end of file
+#endif // SOCKET_BUFFER_HPP
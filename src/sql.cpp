@@ -201,6 +201,22 @@ StmtHandle::StmtHandle(const DbcHandle& dbc) {
                      dbc.get(), SQL_HANDLE_DBC, "SQLAllocHandle (STMT)");
 }
 
+void StmtHandle::apply_deadline() {
+    SQLULEN timeout = 0;
+    if (const auto left = util::deadline::remaining()) {
+        if (left->count() == 0) {
+            throw sql::error("Request deadline exceeded before SQLExecute", "HYT00");
+        }
+        // ODBC counts whole seconds; rounding up lets the driver report the timeout, not cut the query early
+        timeout = static_cast<SQLULEN>(std::chrono::ceil<std::chrono::seconds>(*left).count());
+    }
+    if (timeout != m_query_timeout) {
+        check_odbc_error(SQLSetStmtAttr(get(), SQL_ATTR_QUERY_TIMEOUT, reinterpret_cast<SQLPOINTER>(timeout), 0), // NOSONAR: ODBC passes integers as pointers
+                         get(), SQL_HANDLE_STMT, "SQLSetStmtAttr (QUERY_TIMEOUT)");
+        m_query_timeout = timeout;
+    }
+}
+
 // --- Connection Implementation ---
 
 Connection::Connection(std::string_view conn_str) : m_dbc(SharedEnvHandle::get()) {
@@ -211,6 +227,12 @@ Connection::Connection(std::string_view conn_str) : m_dbc(SharedEnvHandle::get()
     check_odbc_error(retcode, m_dbc.get(), SQL_HANDLE_DBC, "SQLDriverConnect");
 }
 
+Connection::~Connection() noexcept {
+    // Statement handles must be freed before the connection is closed; errors are moot at this point
+    m_statement_cache.clear();
+    SQLDisconnect(m_dbc.get());
+}
+
 StmtHandle& Connection::get_or_create_statement(std::string_view sql_query) {
     if (auto it = m_statement_cache.find(sql_query); it != m_statement_cache.end()) {
         return *it->second;
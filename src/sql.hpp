@@ -3,6 +3,8 @@
 
 #include "env.hpp"
 #include "logger.hpp"
+#include "deadline.hpp"
+#include "text_scan.hpp"
 #include <string>
 #include <string_view>
 #include <vector>
@@ -151,7 +153,10 @@ class StmtHandle : public ODBCHandle<SQL_HANDLE_STMT> {
 public:
     explicit StmtHandle(const DbcHandle& dbc);
     [[nodiscard]] resultset fetch_all() const;
+    // Bounds the next SQLExecute by the calling thread's request deadline; throws HYT00 once it has passed
+    void apply_deadline();
 private:
+    SQLULEN m_query_timeout{0}; // seconds, as last set on the statement; 0 = none
     static std::vector<std::string> get_column_names(SQLHSTMT stmt_handle, SQLSMALLINT num_cols);
     static row fetch_single_row(SQLHSTMT stmt_handle, SQLSMALLINT num_cols, const std::vector<std::string>& col_names);
 };
@@ -179,6 +184,10 @@ void check_odbc_error(SQLRETURN retcode, SQLHANDLE handle, SQLSMALLINT handle_ty
 class Connection {
 public:
     explicit Connection(std::string_view conn_str);
+    // Closes the session: worker threads retired by an elastic pool release theirs through the thread_local cache
+    ~Connection() noexcept;
+    Connection(const Connection&) = delete;
+    Connection& operator=(const Connection&) = delete;
     DbcHandle& get_dbc() { return m_dbc; }
     StmtHandle& get_or_create_statement(std::string_view sql_query);
 
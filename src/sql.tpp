@@ -185,6 +185,7 @@ template<typename... Args>
                 detail::bind_all_params(stmt, params_tuple, indicators);
             }
 
+            stmt.apply_deadline();
             const auto start_time = std::chrono::high_resolution_clock::now();
             
             SQLRETURN ret = SQLExecute(stmt.get());
@@ -232,6 +233,7 @@ template<typename... Args>
                 detail::bind_all_params(stmt, params_tuple, indicators);
             }
             
+            stmt.apply_deadline();
             const auto start_time = std::chrono::high_resolution_clock::now();
             SQLRETURN ret = SQLExecute(stmt.get());
 
@@ -278,6 +280,7 @@ void exec(std::string_view db_key, std::string_view sql_query, Args&&... args) {
                 detail::bind_all_params(stmt, params_tuple, indicators);
             }
             
+            stmt.apply_deadline();
             const auto start_time = std::chrono::high_resolution_clock::now();
             SQLRETURN ret = SQLExecute(stmt.get());
             
@@ -311,25 +314,7 @@ namespace detail {
     // Helper to escape characters for a JSON string literal.
     inline void append_escaped_json_string(std::string& builder, std::string_view sv) {
         builder.push_back('"');
-        for (char c : sv) {
-            switch (c) {
-                case '"':  builder.append(R"(\")"); break;
-                case '\\': builder.append(R"(\\)"); break;
-                case '\b': builder.append("\\b"); break;
-                case '\f': builder.append("\\f"); break;
-                case '\n': builder.append("\\n"); break;
-                case '\r': builder.append("\\r"); break;
-                case '\t': builder.append("\\t"); break;
-                default:
-                    if ('\x{00}' <= c && c <= '\x{1f}') {
-                        // Append control characters as unicode escapes, though this is rare.
-                        builder.append(std::format("\\u{:04x}", static_cast<unsigned char>(c)));
-                    } else {
-                        builder.push_back(c);
-                    }
-                    break;
-            }
-        }
+        util::text::append_json_escaped(builder, sv);
         builder.push_back('"');
     }
 
@@ -472,6 +457,7 @@ template<typename... Args>
                 detail::bind_all_params(stmt, params_tuple, indicators);
             }
             
+            stmt.apply_deadline();
             const auto start_time = std::chrono::high_resolution_clock::now();
             SQLRETURN ret = SQLExecute(stmt.get());
             const auto duration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start_time);
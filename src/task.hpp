@@ -0,0 +1,183 @@
+#ifndef TASK_HPP
+#define TASK_HPP
+
+#include "deadline.hpp"
+#include "logger.hpp"
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <string_view>
+#include <utility>
+
+/**
+ * @brief Coroutine support for API handlers that wait on databases and remote services without holding a thread.
+ *
+ * A handler returning async::task<void> runs on a worker until its first co_await; the thread then goes back
+ * to the pool and the handler resumes on the thread that completed the wait (a blocking pool thread for SQL,
+ * the libcurl multi thread for HTTP). When it returns, the server posts the response to the I/O thread that
+ * owns the connection.
+ */
+namespace async {
+
+/**
+ * @class resume_context
+ * @brief The thread-local state a handler relies on, carried across a suspension.
+ * @details Awaitables capture it when the handler suspends and restore it on the thread that resumes it,
+ * so deadlines bound every call of the request and log lines keep their request ID.
+ */
+class resume_context {
+public:
+    [[nodiscard]] static resume_context capture() noexcept {
+        return resume_context(util::deadline::current(), util::log::current_request_id());
+    }
+
+    // Runs fn under the captured deadline and request ID
+    template<typename F>
+    void apply(F&& fn) const {
+        const util::deadline::scope deadline_scope(m_deadline);
+        const util::log::request_id_scope rid_scope(m_request_id);
+        std::forward<F>(fn)();
+    }
+
+    void resume(std::coroutine_handle<> handle) const {
+        apply([handle] { handle.resume(); });
+    }
+
+private:
+    resume_context(util::deadline::clock::time_point deadline, std::string_view request_id) noexcept
+        : m_deadline(deadline), m_request_id(request_id) {}
+
+    util::deadline::clock::time_point m_deadline;
+    std::string_view m_request_id; // points into the request, which the suspended handler keeps alive
+};
+
+template<typename T>
+class task;
+
+namespace detail {
+
+    // Resumes whoever awaited the finished task, without growing the stack
+    struct final_awaiter {
+        [[nodiscard]] bool await_ready() const noexcept { return false; }
+
+        template<typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) const noexcept {
+            if (auto continuation = handle.promise().m_continuation) {
+                return continuation;
+            }
+            return std::noop_coroutine();
+        }
+
+        void await_resume() const noexcept {
+            // Nothing to produce: the result is read from the promise
+        }
+    };
+
+    struct promise_base {
+        std::coroutine_handle<> m_continuation;
+        std::exception_ptr m_error;
+
+        [[nodiscard]] std::suspend_always initial_suspend() const noexcept { return {}; }
+        [[nodiscard]] final_awaiter final_suspend() const noexcept { return {}; }
+        void unhandled_exception() noexcept { m_error = std::current_exception(); }
+    };
+
+    template<typename T>
+    struct promise : promise_base {
+        std::optional<T> m_value;
+
+        void return_value(T value) { m_value.emplace(std::move(value)); }
+
+        T result() {
+            if (m_error) std::rethrow_exception(m_error);
+            return std::move(*m_value);
+        }
+    };
+
+    template<>
+    struct promise<void> : promise_base {
+        void return_void() const noexcept {
+            // The caller only waits for completion
+        }
+
+        void result() const {
+            if (m_error) std::rethrow_exception(m_error);
+        }
+    };
+
+} // namespace detail
+
+/**
+ * @class task
+ * @brief A lazily started coroutine that produces a T, or rethrows its exception, when co_awaited.
+ * @tparam T The result type; void for API handlers.
+ */
+template<typename T = void>
+class [[nodiscard]] task {
+public:
+    struct promise_type : detail::promise<T> {
+        task get_return_object() noexcept {
+            return task(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+    };
+
+    task(task&& other) noexcept : m_handle(std::exchange(other.m_handle, {})) {}
+
+    task& operator=(task&& other) noexcept {
+        if (this != &other) {
+            if (m_handle) m_handle.destroy();
+            m_handle = std::exchange(other.m_handle, {});
+        }
+        return *this;
+    }
+
+    task(const task&) = delete;
+    task& operator=(const task&) = delete;
+
+    ~task() noexcept {
+        if (m_handle) m_handle.destroy();
+    }
+
+    // Starts the task; the awaiting coroutine resumes when it finishes
+    auto operator co_await() && noexcept {
+        struct awaiter {
+            std::coroutine_handle<promise_type> handle;
+
+            [[nodiscard]] bool await_ready() const noexcept { return !handle || handle.done(); }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) const noexcept {
+                handle.promise().m_continuation = awaiting;
+                return handle;
+            }
+
+            T await_resume() const { return handle.promise().result(); }
+        };
+        return awaiter{m_handle};
+    }
+
+private:
+    explicit task(std::coroutine_handle<promise_type> handle) noexcept : m_handle(handle) {}
+
+    std::coroutine_handle<promise_type> m_handle;
+};
+
+/**
+ * @brief Return type of a fire-and-forget coroutine: it starts at once and frees itself when done.
+ * @details Used by the server for the root of a coroutine request, which must handle every exception itself.
+ */
+struct detached {
+    struct promise_type {
+        [[nodiscard]] detached get_return_object() const noexcept { return {}; }
+        [[nodiscard]] std::suspend_never initial_suspend() const noexcept { return {}; }
+        [[nodiscard]] std::suspend_never final_suspend() const noexcept { return {}; }
+        void return_void() const noexcept {
+            // The frame is destroyed on completion
+        }
+        void unhandled_exception() const noexcept { std::terminate(); }
+    };
+};
+
+} // namespace async
+
+#endif // TASK_HPP
@@ -0,0 +1,293 @@
+#ifndef TEXT_SCAN_HPP
+#define TEXT_SCAN_HPP
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+/**
+ * @brief Byte-scanning kernels for the request parser, the validators and the JSON escapers.
+ *
+ * A char_class is a set of bytes encoded as two 16-entry nibble tables, so one byte is tested with two
+ * table lookups and an AND; with PSHUFB that test runs on 32 (AVX2) or 16 (SSSE3) bytes per instruction.
+ * The vector path is picked at run time from CPUID, or at compile time when the build targets x86-64-v3;
+ * other CPUs, and inputs shorter than one vector, use the same tables one byte at a time.
+ */
+namespace util::text {
+
+/**
+ * @class char_class
+ * @brief A set of bytes, built at compile time, for find_first_of() and find_first_not_of().
+ * @details Bytes are grouped by high nibble; the groups may hold at most 8 distinct sets of low nibbles,
+ * which every class used by the server does. A class that does not fit fails to compile.
+ */
+class char_class {
+public:
+    // The bytes of members
+    [[nodiscard]] static consteval char_class of(std::string_view members) {
+        std::array<uint16_t, 16> rows{};
+        for (const char c : members) {
+            const auto b = static_cast<unsigned char>(c);
+            rows[b >> 4] |= static_cast<uint16_t>(1u << (b & 0x0f));
+        }
+        return char_class(rows);
+    }
+
+    // The bytes for which pred(unsigned char) is true
+    template<typename Pred>
+    [[nodiscard]] static consteval char_class where(Pred pred) {
+        std::array<uint16_t, 16> rows{};
+        for (unsigned b = 0; b < 256; ++b) {
+            if (pred(static_cast<unsigned char>(b))) rows[b >> 4] |= static_cast<uint16_t>(1u << (b & 0x0f));
+        }
+        return char_class(rows);
+    }
+
+    [[nodiscard]] constexpr bool contains(unsigned char c) const noexcept {
+        return (m_lo[c & 0x0f] & m_hi[c >> 4]) != 0;
+    }
+
+    [[nodiscard]] constexpr const std::array<uint8_t, 16>& lo_table() const noexcept { return m_lo; }
+    [[nodiscard]] constexpr const std::array<uint8_t, 16>& hi_table() const noexcept { return m_hi; }
+
+private:
+    // rows[h] has bit l set when byte (h << 4 | l) is a member; equal rows share one of the 8 bits
+    consteval explicit char_class(const std::array<uint16_t, 16>& rows) {
+        std::array<uint16_t, 8> buckets{};
+        size_t used = 0;
+        for (size_t h = 0; h < rows.size(); ++h) {
+            if (rows[h] == 0) continue;
+            size_t b = 0;
+            while (b < used && buckets[b] != rows[h]) ++b;
+            if (b == used) {
+                if (used == buckets.size()) throw std::invalid_argument("char_class: too many distinct nibble rows");
+                buckets[used++] = rows[h];
+            }
+            m_hi[h] |= static_cast<uint8_t>(1u << b);
+            for (size_t l = 0; l < 16; ++l) {
+                if (rows[h] & (1u << l)) m_lo[l] |= static_cast<uint8_t>(1u << b);
+            }
+        }
+    }
+
+    std::array<uint8_t, 16> m_lo{};
+    std::array<uint8_t, 16> m_hi{};
+};
+
+// Bytes a JSON string literal cannot hold as they are
+inline constexpr char_class json_escape_chars = char_class::where([](unsigned char c) {
+    return c < 0x20 || c == '"' || c == '\\';
+});
+
+namespace detail {
+
+    // Match: stop at the first member; otherwise stop at the first non-member
+    template<bool Match>
+    [[nodiscard]] inline size_t scan_scalar(const char* data, size_t size, const char_class& cls) noexcept {
+        for (size_t i = 0; i < size; ++i) {
+            if (cls.contains(static_cast<unsigned char>(data[i])) == Match) return i;
+        }
+        return std::string_view::npos;
+    }
+
+#if defined(__x86_64__)
+    struct cpu_features {
+        bool avx2{false};
+        bool ssse3{false};
+    };
+
+    [[nodiscard]] inline const cpu_features& cpu() noexcept {
+        static const cpu_features features = [] {
+            __builtin_cpu_init(); // may run before libgcc's own constructor
+            return cpu_features{__builtin_cpu_supports("avx2") != 0, __builtin_cpu_supports("ssse3") != 0};
+        }();
+        return features;
+    }
+
+    [[nodiscard]] inline bool use_avx2() noexcept {
+#if defined(__AVX2__)
+        return true;
+#else
+        return cpu().avx2;
+#endif
+    }
+
+    [[nodiscard]] inline bool use_ssse3() noexcept {
+#if defined(__SSSE3__)
+        return true;
+#else
+        return cpu().ssse3;
+#endif
+    }
+
+    // Bit i set when byte i of the 32 at p stops the scan
+    template<bool Match>
+    [[gnu::target("avx2")]] [[nodiscard]] inline uint32_t block_avx2(const char* p, __m256i lo_table, __m256i hi_table) noexcept {
+        const __m256i nibble = _mm256_set1_epi8(0x0f);
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); // NOSONAR: SIMD load
+        const __m256i lo = _mm256_shuffle_epi8(lo_table, _mm256_and_si256(v, nibble));
+        const __m256i hi = _mm256_shuffle_epi8(hi_table, _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble));
+        const auto outside = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_and_si256(lo, hi), _mm256_setzero_si256())));
+        return Match ? ~outside : outside;
+    }
+
+    // Requires size >= 32; the last block overlaps the one before it, whose bytes are already known not to stop the scan
+    template<bool Match>
+    [[gnu::target("avx2")]] [[nodiscard]] inline size_t scan_avx2(const char* data, size_t size, const char_class& cls) noexcept {
+        const __m256i lo_table = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(cls.lo_table().data()))); // NOSONAR: SIMD load
+        const __m256i hi_table = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(cls.hi_table().data()))); // NOSONAR: SIMD load
+        size_t i = 0;
+        for (; i + 32 <= size; i += 32) {
+            if (const uint32_t hits = block_avx2<Match>(data + i, lo_table, hi_table)) return i + static_cast<size_t>(std::countr_zero(hits));
+        }
+        if (i < size) {
+            i = size - 32;
+            if (const uint32_t hits = block_avx2<Match>(data + i, lo_table, hi_table)) return i + static_cast<size_t>(std::countr_zero(hits));
+        }
+        return std::string_view::npos;
+    }
+
+    // Bit i set when byte i of the 16 at p stops the scan
+    template<bool Match>
+    [[gnu::target("ssse3")]] [[nodiscard]] inline uint32_t block_ssse3(const char* p, __m128i lo_table, __m128i hi_table) noexcept {
+        const __m128i nibble = _mm_set1_epi8(0x0f);
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); // NOSONAR: SIMD load
+        const __m128i lo = _mm_shuffle_epi8(lo_table, _mm_and_si128(v, nibble));
+        const __m128i hi = _mm_shuffle_epi8(hi_table, _mm_and_si128(_mm_srli_epi16(v, 4), nibble));
+        const auto outside = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(lo, hi), _mm_setzero_si128())));
+        return Match ? ~outside & 0xffffu : outside;
+    }
+
+    // Requires size >= 16; same structure as scan_avx2
+    template<bool Match>
+    [[gnu::target("ssse3")]] [[nodiscard]] inline size_t scan_ssse3(const char* data, size_t size, const char_class& cls) noexcept {
+        const __m128i lo_table = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cls.lo_table().data())); // NOSONAR: SIMD load
+        const __m128i hi_table = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cls.hi_table().data())); // NOSONAR: SIMD load
+        size_t i = 0;
+        for (; i + 16 <= size; i += 16) {
+            if (const uint32_t hits = block_ssse3<Match>(data + i, lo_table, hi_table)) return i + static_cast<size_t>(std::countr_zero(hits));
+        }
+        if (i < size) {
+            i = size - 16;
+            if (const uint32_t hits = block_ssse3<Match>(data + i, lo_table, hi_table)) return i + static_cast<size_t>(std::countr_zero(hits));
+        }
+        return std::string_view::npos;
+    }
+#endif
+
+    template<bool Match>
+    [[nodiscard]] inline size_t scan(std::string_view sv, const char_class& cls) noexcept {
+#if defined(__x86_64__)
+        if (sv.size() >= 32 && use_avx2()) return scan_avx2<Match>(sv.data(), sv.size(), cls);
+        if (sv.size() >= 16 && use_ssse3()) return scan_ssse3<Match>(sv.data(), sv.size(), cls);
+#endif
+        return scan_scalar<Match>(sv.data(), sv.size(), cls);
+    }
+
+    // Loads up to 8 bytes into a word, zero-padded
+    [[nodiscard]] inline uint64_t load_word(const char* p, size_t n) noexcept {
+        uint64_t w = 0;
+        std::memcpy(&w, p, n);
+        return w;
+    }
+
+    // Lower-cases the ASCII letters of 8 bytes at once; other bytes, UTF-8 included, are left alone
+    [[nodiscard]] constexpr uint64_t fold_word(uint64_t w) noexcept {
+        constexpr uint64_t ones = 0x0101010101010101ull;
+        constexpr uint64_t high = ones * 0x80;
+        const uint64_t low7 = w & ~high;
+        const uint64_t at_least_a = low7 + ones * (0x80 - 'A');
+        const uint64_t above_z = low7 + ones * (0x80 - 'Z' - 1);
+        const uint64_t upper = at_least_a & ~above_z & ~w & high;
+        return w | (upper >> 2);
+    }
+
+} // namespace detail
+
+// Position of the first byte of sv in cls, or npos
+[[nodiscard]] inline size_t find_first_of(std::string_view sv, const char_class& cls) noexcept {
+    return detail::scan<true>(sv, cls);
+}
+
+// Position of the first byte of sv not in cls, or npos
+[[nodiscard]] inline size_t find_first_not_of(std::string_view sv, const char_class& cls) noexcept {
+    return detail::scan<false>(sv, cls);
+}
+
+// True if every byte of sv is in cls
+[[nodiscard]] inline bool all_of(std::string_view sv, const char_class& cls) noexcept {
+    return find_first_not_of(sv, cls) == std::string_view::npos;
+}
+
+/**
+ * @brief Appends sv to out as the inside of a JSON string literal.
+ * @details Runs of bytes that need no escape, normally the whole string, are found by the vector scan
+ * and copied with one append.
+ */
+inline void append_json_escaped(std::string& out, std::string_view sv) {
+    constexpr std::string_view hex = "0123456789abcdef";
+    while (!sv.empty()) {
+        const size_t pos = find_first_of(sv, json_escape_chars);
+        if (pos == std::string_view::npos) {
+            out.append(sv);
+            return;
+        }
+        out.append(sv.substr(0, pos));
+        switch (const auto c = static_cast<unsigned char>(sv[pos])) {
+            case '"':  out.append(R"(\")"); break;
+            case '\\': out.append(R"(\\)"); break;
+            case '\b': out.append(R"(\b)"); break;
+            case '\f': out.append(R"(\f)"); break;
+            case '\n': out.append(R"(\n)"); break;
+            case '\r': out.append(R"(\r)"); break;
+            case '\t': out.append(R"(\t)"); break;
+            default: // other control characters, which are rare
+                out.append(R"(\u00)");
+                out.push_back(hex[c >> 4]);
+                out.push_back(hex[c & 0x0f]);
+                break;
+        }
+        sv.remove_prefix(pos + 1);
+    }
+}
+
+// ASCII case-insensitive equality, 8 bytes per step
+[[nodiscard]] inline bool iequals(std::string_view lhs, std::string_view rhs) noexcept {
+    if (lhs.size() != rhs.size()) return false;
+    size_t i = 0;
+    for (; i + 8 <= lhs.size(); i += 8) {
+        if (detail::fold_word(detail::load_word(lhs.data() + i, 8)) != detail::fold_word(detail::load_word(rhs.data() + i, 8))) return false;
+    }
+    const size_t rest = lhs.size() - i;
+    return rest == 0 ||
+           detail::fold_word(detail::load_word(lhs.data() + i, rest)) == detail::fold_word(detail::load_word(rhs.data() + i, rest));
+}
+
+// ASCII case-insensitive hash, 8 bytes per step; equal under iequals() means equal hash
+[[nodiscard]] inline size_t ihash(std::string_view sv) noexcept {
+    constexpr uint64_t mul = 0x9e3779b97f4a7c15ull;
+    uint64_t h = (sv.size() + 1) * mul;
+    size_t i = 0;
+    for (; i + 8 <= sv.size(); i += 8) {
+        h = (h ^ detail::fold_word(detail::load_word(sv.data() + i, 8))) * mul;
+        h ^= h >> 29;
+    }
+    if (const size_t rest = sv.size() - i; rest != 0) {
+        h = (h ^ detail::fold_word(detail::load_word(sv.data() + i, rest))) * mul;
+        h ^= h >> 29;
+    }
+    return static_cast<size_t>(h);
+}
+
+} // namespace util::text
+
+#endif // TEXT_SCAN_HPP
@@ -2,25 +2,83 @@
 #define THREAD_POOL_HPP
 
 #include "shared_queue.hpp"
+#include "mpmc_ring.hpp"
+#include "inline_task.hpp"
 #include "logger.hpp"
 #include <vector>
 #include <thread>
-#include <functional>
 #include <atomic>
 #include <stdexcept>
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <linux/futex.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 
-using dispatch_task = std::function<void()>;
+// Room for the pointer to a dispatched request's job, with space to spare
+using dispatch_task = inline_task<64>;
 
 class thread_pool {
 public:
     /**
-     * @brief Constructs the thread pool with a single global MPMC queue.
+     * @brief Scheduling class of a task within its pool.
+     * @details Workers take high before normal before low, except that every few pops a worker looks at
+     * the lower classes first, so a steady stream of high priority work cannot starve them.
+     */
+    enum class priority : uint8_t { high, normal, low };
+
+    static constexpr size_t DEFAULT_CAPACITY{65536};
+    static constexpr size_t PRIORITY_LEVELS{3};
+    static constexpr unsigned AGING_INTERVAL{8}; // every Nth pop scans the priorities from the lowest
+
+    /**
+     * @brief How many workers a pool runs.
+     * @details The pool starts with min_threads. It adds a worker, up to max_threads, when a task is pushed
+     * while every worker is busy, none has dequeued anything for grow_after, and the workers spent less than
+     * half of the last sampling window on the CPU: they are blocked (typically waiting on the database) and
+     * another thread can make progress. CPU-bound workers are not joined by more. A worker above min_threads
+     * that finds no work for idle_timeout exits.
+     */
+    struct sizing {
+        size_t min_threads;
+        size_t max_threads;                            // equal to min_threads for a fixed-size pool
+        std::chrono::milliseconds grow_after{10};
+        std::chrono::seconds idle_timeout{60};
+    };
+
+    /**
+     * @brief Constructs a fixed-size thread pool around lock-free bounded MPMC rings of tasks, one per priority.
      * @param num_threads The number of worker threads to spawn.
-     * @param queue_capacity The maximum number of tasks in the global queue. 0 = unbounded.
+     * @param queue_capacity The maximum number of queued tasks, all priorities together. 0 = DEFAULT_CAPACITY.
+     * Each priority's ring holds its share of it, a third rounded up.
+     * @param name The pool's name, used in logs and metrics.
      */
-    explicit thread_pool(size_t num_threads, size_t queue_capacity = 0)
-        : m_num_threads(num_threads), 
-          m_global_queue(queue_capacity) { // Initialize the single shared queue directly
+    explicit thread_pool(size_t num_threads, size_t queue_capacity = 0, std::string name = "default")
+        : thread_pool(sizing{num_threads, num_threads}, queue_capacity, std::move(name)) {
+    }
+
+    /**
+     * @brief Constructs an elastic thread pool.
+     * @param size The bounds and timing of resizing; max_threads is raised to min_threads if lower.
+     */
+    thread_pool(const sizing& size, size_t queue_capacity, std::string name)
+        : m_min_threads(std::max<size_t>(size.min_threads, 1)),
+          m_max_threads(std::max(size.max_threads, m_min_threads)),
+          m_grow_after(size.grow_after),
+          m_idle_timeout(size.idle_timeout),
+          m_name(std::move(name)),
+          m_capacity(queue_capacity == 0 ? DEFAULT_CAPACITY : queue_capacity),
+          m_rings{ring_type(ring_share()), ring_type(ring_share()), ring_type(ring_share())} {
     }
 
     // Rule of 5: Concurrency managers must not be copyable or movable
@@ -34,12 +92,17 @@ public:
     }
 
     void start() {
-        m_threads.reserve(m_num_threads);
-        for (size_t i = 0; i < m_num_threads; ++i) {
-            // Spawn C++20 jthreads which automatically join on destruction
-            m_threads.emplace_back([this, i] { worker_loop(i); });
+        const std::scoped_lock lock(m_workers_mutex);
+        // Workers added later are spawned by a producer, which may be pinned elsewhere: they all take the starter's CPUs
+        m_has_cpus = pthread_getaffinity_np(pthread_self(), sizeof(m_cpus), &m_cpus) == 0;
+        for (size_t i = 0; i < m_min_threads; ++i) {
+            spawn_worker();
+        }
+        if (m_max_threads > m_min_threads) {
+            util::log::info("Thread pool {} started with {} workers, elastic up to {}.", m_name, m_min_threads, m_max_threads);
+        } else {
+            util::log::info("Thread pool {} started with {} workers.", m_name, m_min_threads);
         }
-        util::log::info("Thread pool started with {} workers.", m_num_threads);
     }
 
     void stop() {
@@ -48,37 +111,132 @@ public:
             return;
         }
         
-        m_global_queue.stop();
+        // Parked workers wake up, drain what is left in the ring and exit
+        m_epoch.fetch_add(1, std::memory_order_release);
+        futex_wake(m_epoch, INT_MAX);
         
-        // Clearing the vector destructs the jthreads, which safely blocks until they finish
-        m_threads.clear();
+        // Destroying the jthreads safely blocks until they finish; none is added once stopped
+        std::vector<std::unique_ptr<worker>> workers;
+        {
+            const std::scoped_lock lock(m_workers_mutex);
+            workers.swap(m_workers);
+        }
+        workers.clear();
         try {
-            util::log::info("Thread pool stopped.");
+            util::log::info("Thread pool {} stopped.", m_name);
         } catch (/* NOSONAR */ const std::exception& e) {
         }
     }
 
     /**
-     * @brief Pushes a task to the single global queue.
-     * @throws queue_full_error if the queue has reached its maximum capacity.
+     * @brief Pushes a task to the ring of its priority, waking a parked worker if there is one.
+     * @throws queue_full_error if the pool already holds its capacity of queued tasks, or the ring of this priority
+     * its share of it; task is left untouched.
      */
-    void push_task(dispatch_task task) {
+    void push_task(dispatch_task&& task, priority prio = priority::normal) {
         // FIX 1: Increment unfinished tasks *before* pushing to prevent shutdown race conditions
         m_unfinished_tasks.fetch_add(1, /* NOSONAR */ std::memory_order_release);
-        try {
-            m_global_queue.push(std::move(task));
-        } catch (...) {
+        // The slot is reserved against the pool's capacity, then taken in the ring, which holds only a share of it
+        if (m_queued.fetch_add(1, std::memory_order_relaxed) >= m_capacity || !m_rings[static_cast<size_t>(prio)].try_push(task)) {
+            m_queued.fetch_sub(1, std::memory_order_relaxed);
             m_unfinished_tasks.fetch_sub(1, /* NOSONAR */ std::memory_order_relaxed);
-            throw;
+            m_rejected_tasks.fetch_add(1, /* NOSONAR */ std::memory_order_relaxed);
+            throw queue_full_error("Queue is full");
+        }
+        // Pairs with the fence in park(): either the worker sees the task or this sees the sleeper
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_sleepers.load(std::memory_order_relaxed) > 0) {
+            wake_one();
+            return;
+        }
+        // Every worker here is busy: a parked sibling can steal the task instead
+        for (thread_pool* sibling : m_siblings) {
+            if (sibling->m_sleepers.load(std::memory_order_relaxed) > 0) {
+                sibling->wake_one();
+                return;
+            }
+        }
+        if (m_live_threads.load(std::memory_order_relaxed) < m_max_threads) {
+            maybe_grow();
         }
     }
 
+    /**
+     * @brief Lets idle workers of this pool take tasks queued in the other pools of the group.
+     * Call it before start() on every pool of the group; all of them must be stopped before any is destroyed.
+     * A stolen task still counts as unfinished in the pool it was pushed to, until it completes.
+     * @param group The pools sharing work; may include this one.
+     */
+    void set_steal_group(const std::vector<thread_pool*>& group) {
+        m_siblings.clear();
+        for (thread_pool* pool : group) {
+            if (pool != this) {
+                m_siblings.push_back(pool);
+            }
+        }
+    }
+
+    /**
+     * @brief Returns the number of tasks this pool's workers took from sibling pools.
+     */
+    [[nodiscard]] uint64_t get_stolen_tasks() const {
+        return m_stolen_tasks.load(/* NOSONAR */ std::memory_order_relaxed);
+    }
+
     /**
      * @brief Returns the number of tasks currently waiting in the queue.
      * Useful for metrics reporting.
      */
     [[nodiscard]] size_t get_total_pending_tasks() const {
-        return m_global_queue.size();
+        size_t pending = 0;
+        for (const auto& ring : m_rings) pending += ring.size();
+        return pending;
+    }
+
+    [[nodiscard]] size_t get_pending_tasks(priority prio) const {
+        return m_rings[static_cast<size_t>(prio)].size();
+    }
+
+    [[nodiscard]] const std::string& get_name() const noexcept {
+        return m_name;
+    }
+
+    // Workers currently alive; between the minimum and maximum size
+    [[nodiscard]] size_t get_thread_count() const noexcept {
+        return m_live_threads.load(/* NOSONAR */ std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] size_t get_min_threads() const noexcept {
+        return m_min_threads;
+    }
+
+    [[nodiscard]] size_t get_max_threads() const noexcept {
+        return m_max_threads;
+    }
+
+    // Workers added because the queue stalled
+    [[nodiscard]] uint64_t get_grow_events() const {
+        return m_grow_events.load(/* NOSONAR */ std::memory_order_relaxed);
+    }
+
+    // Workers retired after an idle period
+    [[nodiscard]] uint64_t get_shrink_events() const {
+        return m_shrink_events.load(/* NOSONAR */ std::memory_order_relaxed);
+    }
+
+    // Queue slots of the pool, shared by the priorities
+    [[nodiscard]] size_t get_queue_capacity() const noexcept {
+        return m_capacity;
+    }
+
+    // Workers running a task, including tasks stolen from sibling pools
+    [[nodiscard]] size_t get_busy_threads() const {
+        return m_busy_threads.load(/* NOSONAR */ std::memory_order_relaxed);
+    }
+
+    // Tasks refused because the queue was full
+    [[nodiscard]] uint64_t get_rejected_tasks() const {
+        return m_rejected_tasks.load(/* NOSONAR */ std::memory_order_relaxed);
     }
 
     /**
@@ -90,37 +248,240 @@ public:
     }
 
 private:
+    struct worker {
+        std::jthread thread;
+        std::atomic<bool> finished{false}; // set by the thread as its last action; it can then be joined at once
+        clockid_t cpu_clock{};             // the thread's CPU-time clock, valid when has_cpu_clock
+        bool has_cpu_clock{false};
+        int64_t cpu_seen{0};               // CPU nanoseconds at the previous sample
+    };
+
+    enum class park_result { woken, retire };
+
+    // Cells in each priority's ring: the capacity split evenly, rounded up (the ring rounds again to a power of two)
+    [[nodiscard]] size_t ring_share() const noexcept {
+        return (m_capacity + PRIORITY_LEVELS - 1) / PRIORITY_LEVELS;
+    }
+
+    // With m_workers_mutex held
+    void spawn_worker() {
+        auto& w = m_workers.emplace_back(std::make_unique<worker>());
+        m_live_threads.fetch_add(1, /* NOSONAR */ std::memory_order_relaxed);
+        // Spawn C++20 jthreads which automatically join on destruction
+        w->thread = std::jthread([this, id = m_next_worker_id++, done = &w->finished] {
+            if (m_has_cpus) {
+                pthread_setaffinity_np(pthread_self(), sizeof(m_cpus), &m_cpus);
+            }
+            worker_loop(id);
+            done->store(true, std::memory_order_release);
+        });
+        w->has_cpu_clock = pthread_getcpuclockid(w->thread.native_handle(), &w->cpu_clock) == 0;
+    }
+
+    // Producer side, after a push found every worker busy
+    void maybe_grow() {
+        const auto now = clock::now().time_since_epoch().count();
+        if (m_busy_threads.load(std::memory_order_relaxed) < m_live_threads.load(std::memory_order_relaxed)
+            || now - m_last_dequeue.load(std::memory_order_relaxed) < std::chrono::nanoseconds(m_grow_after).count()) {
+            return;
+        }
+        const std::unique_lock lock(m_workers_mutex, std::try_to_lock);
+        if (!lock.owns_lock() || m_stopped.load(std::memory_order_acquire)
+            || m_live_threads.load(std::memory_order_relaxed) >= m_max_threads) {
+            return;
+        }
+        std::erase_if(m_workers, [](const auto& w) { return w->finished.load(std::memory_order_acquire); });
+        if (!workers_off_cpu(now)) {
+            return;
+        }
+        spawn_worker();
+        m_last_dequeue.store(now, std::memory_order_relaxed); // give the new worker grow_after before adding another
+        m_grow_events.fetch_add(1, /* NOSONAR */ std::memory_order_relaxed);
+        util::log::debug("Thread pool {} grew to {} workers.", m_name, m_live_threads.load(std::memory_order_relaxed));
+    }
+
+    // With m_workers_mutex held. True when the workers were on the CPU less than half of the wall time since the
+    // previous sample, so they are mostly blocked. A window shorter than grow_after is too noisy to judge and is
+    // left running; one longer than four times grow_after is stale and only starts a new window.
+    bool workers_off_cpu(std::chrono::steady_clock::rep now) {
+        const auto grow_after = std::chrono::nanoseconds(m_grow_after).count();
+        const auto window = now - m_cpu_sampled_at;
+        if (window < grow_after) {
+            return false;
+        }
+        m_cpu_sampled_at = now;
+        int64_t on_cpu = 0;
+        size_t sampled = 0;
+        for (const auto& w : m_workers) {
+            timespec ts{};
+            if (!w->has_cpu_clock || clock_gettime(w->cpu_clock, &ts) != 0) {
+                continue;
+            }
+            const int64_t cpu = static_cast<int64_t>(ts.tv_sec) * 1'000'000'000 + ts.tv_nsec;
+            on_cpu += cpu - w->cpu_seen;
+            w->cpu_seen = cpu;
+            ++sampled;
+        }
+        if (window > 4 * grow_after || sampled == 0) {
+            return false;
+        }
+        return on_cpu * 2 < static_cast<int64_t>(window) * static_cast<int64_t>(sampled);
+    }
+
+    // A parked worker that timed out leaves if the pool is above its minimum size
+    bool try_retire() {
+        size_t live = m_live_threads.load(std::memory_order_relaxed);
+        while (live > m_min_threads) {
+            if (m_live_threads.compare_exchange_weak(live, live - 1, std::memory_order_relaxed)) {
+                m_shrink_events.fetch_add(1, /* NOSONAR */ std::memory_order_relaxed);
+                util::log::debug("Thread pool {} shrank to {} workers.", m_name, live - 1);
+                return true;
+            }
+        }
+        return false;
+    }
+
     void worker_loop(size_t worker_id) {
         util::log::debug("Worker thread {} started.", worker_id);
 
+        dispatch_task task;
+        unsigned pops = 0;
         while (true) {
-            // Blocks efficiently until the single global queue has a task or is stopped
-            auto task_opt = m_global_queue.wait_and_pop();
-
-            if (!task_opt) {
-                break; // Queue was stopped and is fully drained
+            thread_pool* owner = this;
+            if (!try_pop(task, ++pops % AGING_INTERVAL == 0)) {
+                if (m_stopped.load(std::memory_order_acquire) && empty()) {
+                    m_live_threads.fetch_sub(1, /* NOSONAR */ std::memory_order_relaxed);
+                    break; // Pool was stopped and the rings are fully drained
+                }
+                owner = steal(task, worker_id);
+                if (owner == nullptr) {
+                    if (park() == park_result::retire) {
+                        break; // thread_local state, like the worker's ODBC connections, is released on exit
+                    }
+                    continue;
+                }
             }
             
+            m_last_dequeue.store(clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+            m_busy_threads.fetch_add(1, /* NOSONAR */ std::memory_order_relaxed);
             try {
-                if (*task_opt) {
-                    (*task_opt)(); // Execute the API endpoint handler
+                if (task) {
+                    task(); // Execute the API endpoint handler
                 }
             } catch (/* NOSONAR */ const std::exception& e) {
                 util::log::error("Exception caught in worker thread {}: {}", worker_id, e.what());
             }
+            task.reset(); // releases the captured request before the task counts as finished
+            m_busy_threads.fetch_sub(1, /* NOSONAR */ std::memory_order_relaxed);
 
-            // FIX 1: Decrement only *after* the task is fully processed
-            m_unfinished_tasks.fetch_sub(1, /* NOSONAR */ std::memory_order_release);
+            // FIX 1: Decrement only *after* the task is fully processed, in the pool that accepted it
+            owner->m_unfinished_tasks.fetch_sub(1, /* NOSONAR */ std::memory_order_release);
         }
         util::log::debug("Worker thread {} finished.", worker_id);
     }
 
-    const size_t m_num_threads;
+    // Eventcount: sleeps on a futex until a push or stop() advances the epoch, unless work showed up meanwhile.
+    // Above the minimum size the sleep is bounded by the idle timeout, after which the worker may retire.
+    park_result park() {
+        const uint32_t epoch = m_epoch.load(std::memory_order_acquire);
+        m_sleepers.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        bool timed_out = false;
+        if (empty() && !siblings_have_work() && !m_stopped.load(std::memory_order_acquire)) {
+            if (m_live_threads.load(std::memory_order_relaxed) > m_min_threads) {
+                const timespec timeout{static_cast<time_t>(m_idle_timeout.count()), 0};
+                timed_out = futex_wait(m_epoch, epoch, &timeout) == ETIMEDOUT;
+            } else {
+                futex_wait(m_epoch, epoch, nullptr);
+            }
+        }
+        m_sleepers.fetch_sub(1, std::memory_order_relaxed);
+        if (!timed_out) {
+            return park_result::woken;
+        }
+        // Pairs with the fence in push_task(): a task pushed after this check sees this worker gone and wakes another
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        return empty() && try_retire() ? park_result::retire : park_result::woken;
+    }
+
+    void wake_one() {
+        m_epoch.fetch_add(1, std::memory_order_release);
+        futex_wake(m_epoch, 1);
+    }
+
+    // Raw futex on the epoch word, because std::atomic::wait cannot time out; returns the errno of a failed wait
+    static int futex_wait(std::atomic<uint32_t>& word, uint32_t expected, const timespec* timeout) noexcept {
+        const long rc = syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT_PRIVATE, expected, timeout, nullptr, 0); // NOSONAR: futex on the atomic's storage
+        return rc == -1 ? errno : 0;
+    }
+
+    static void futex_wake(std::atomic<uint32_t>& word, int count) noexcept {
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0); // NOSONAR: futex on the atomic's storage
+    }
+
+    // Tries each sibling once, starting at a different one per worker so thieves spread out
+    thread_pool* steal(dispatch_task& task, size_t worker_id) {
+        const size_t count = m_siblings.size();
+        for (size_t i = 0; i < count; ++i) {
+            thread_pool* victim = m_siblings[(worker_id + i) % count];
+            if (victim->try_pop(task, false)) {
+                m_stolen_tasks.fetch_add(1, /* NOSONAR */ std::memory_order_relaxed);
+                return victim;
+            }
+        }
+        return nullptr;
+    }
+
+    [[nodiscard]] bool siblings_have_work() const {
+        return std::ranges::any_of(m_siblings, [](const thread_pool* p) { return !p->empty(); });
+    }
+
+    // Highest priority first, or lowest first when aging
+    bool try_pop(dispatch_task& task, bool aging) {
+        for (size_t i = 0; i < PRIORITY_LEVELS; ++i) {
+            if (m_rings[aging ? PRIORITY_LEVELS - 1 - i : i].try_pop(task)) {
+                m_queued.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    [[nodiscard]] bool empty() const {
+        return std::ranges::all_of(m_rings, [](const ring_type& r) { return r.empty(); });
+    }
+
+
+    using ring_type = mpmc_ring<dispatch_task>;
+    using clock = std::chrono::steady_clock;
+
+    const size_t m_min_threads;
+    const size_t m_max_threads;
+    const std::chrono::milliseconds m_grow_after;
+    const std::chrono::seconds m_idle_timeout;
+    const std::string m_name;
     std::atomic<bool> m_stopped{false};
     std::atomic<size_t> m_unfinished_tasks{0}; // Tracks tasks both queued AND executing
     
-    shared_queue<dispatch_task> m_global_queue; 
-    std::vector<std::jthread> m_threads;
+    const size_t m_capacity;                        // queued tasks allowed, all priorities together
+    std::atomic<size_t> m_queued{0};                // slots reserved in the rings
+    std::array<ring_type, PRIORITY_LEVELS> m_rings; // indexed by priority, each sized for its share of the capacity
+    std::atomic<uint32_t> m_epoch{0};     // advanced to wake parked workers
+    std::atomic<uint32_t> m_sleepers{0};  // workers parked or about to park
+    std::vector<thread_pool*> m_siblings; // pools this one may steal from, fixed before start()
+    std::atomic<uint64_t> m_stolen_tasks{0};
+    std::atomic<uint64_t> m_rejected_tasks{0};
+    std::atomic<size_t> m_busy_threads{0};
+    std::atomic<size_t> m_live_threads{0};
+    std::atomic<clock::rep> m_last_dequeue{0};  // steady clock ticks
+    clock::rep m_cpu_sampled_at{0};             // steady clock ticks of the last CPU sample, under m_workers_mutex
+    std::atomic<uint64_t> m_grow_events{0};
+    std::atomic<uint64_t> m_shrink_events{0};
+    std::mutex m_workers_mutex;                // guards m_workers and m_next_worker_id
+    std::vector<std::unique_ptr<worker>> m_workers;
+    size_t m_next_worker_id{0};
+    cpu_set_t m_cpus{};                        // affinity of the thread that called start()
+    bool m_has_cpus{false};
 };
 
-#endif // THREAD_POOL_HPP
\ No newline at end of file
+#endif // THREAD_POOL_HPP
\ No newline at end of file
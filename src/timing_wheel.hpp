@@ -0,0 +1,216 @@
+#ifndef TIMING_WHEEL_HPP
+#define TIMING_WHEEL_HPP
+
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <vector>
+
+/**
+ * @brief Hierarchical timing wheel (4 levels x 64 slots) for per-connection deadlines.
+ *
+ * Schedule and cancel are O(1): timers are nodes in a pooled array linked into
+ * per-slot doubly-linked lists and addressed by index, so owners can move freely.
+ * Timers beyond the first level cascade down as the wheel turns. An occupancy
+ * bitmap per level lets next_expiry() find the next non-empty slot without scanning,
+ * which is what the reactor arms its timerfd for. Single-threaded by design.
+ */
+class timing_wheel {
+public:
+    using clock = std::chrono::steady_clock;
+    using timer_id = uint32_t;
+    static constexpr timer_id npos = std::numeric_limits<timer_id>::max();
+
+    explicit timing_wheel(clock::duration resolution, clock::time_point origin = clock::now())
+        : m_resolution(resolution), m_origin(origin) {
+        m_heads.fill(npos);
+    }
+
+    [[nodiscard]] bool empty() const noexcept { return m_count == 0; }
+    [[nodiscard]] size_t size() const noexcept { return m_count; }
+
+    // Deadlines are rounded up to the wheel resolution; past deadlines fire on the next tick
+    timer_id schedule(clock::time_point deadline, uint64_t key) {
+        if (m_count == 0) {
+            // Nothing pending: skip the idle gap instead of stepping through it later
+            m_next_tick = std::max(m_next_tick, tick_of(clock::now()));
+        }
+        const timer_id id = allocate();
+        node& n = m_nodes[id];
+        n.key = key;
+        n.expires = std::max(ceil_tick_of(deadline), m_next_tick);
+        link(id);
+        ++m_count;
+        return id;
+    }
+
+    void cancel(timer_id id) noexcept {
+        if (id == npos) return;
+        unlink(id);
+        release(id);
+        --m_count;
+    }
+
+    // Fires every timer due at or before now, invoking on_expired(key) after the timer is released
+    template<typename Fn>
+    void advance(clock::time_point now, Fn&& on_expired) {
+        const uint64_t target = tick_of(now);
+        while (m_next_tick <= target && m_count > 0) {
+            const uint64_t tick = m_next_tick;
+            // Cascade each level whose lower levels just wrapped around
+            for (unsigned level = 1; level < LEVELS && (tick & ((1ull << (level * SLOT_BITS)) - 1)) == 0; ++level) {
+                cascade(level, slot_of(tick, level));
+            }
+            ++m_next_tick;
+            expire_slot(static_cast<unsigned>(tick & SLOT_MASK), on_expired);
+        }
+        if (m_count == 0) {
+            m_next_tick = std::max(m_next_tick, target + 1);
+        }
+    }
+
+    // When the next non-empty slot is due (expiry or cascade), or nullopt if no timer is pending
+    [[nodiscard]] std::optional<clock::time_point> next_expiry() const noexcept {
+        if (m_count == 0) return std::nullopt;
+        uint64_t best = std::numeric_limits<uint64_t>::max();
+        for (unsigned level = 0; level < LEVELS; ++level) {
+            if (m_occupied[level] == 0) continue;
+            const unsigned shift = level * SLOT_BITS;
+            // First tick at which this level's cursor can reach a new slot
+            const uint64_t base = level == 0 ? m_next_tick : ((m_next_tick + (1ull << shift) - 1) >> shift);
+            const auto start = static_cast<unsigned>(base & SLOT_MASK);
+            const auto offset = static_cast<unsigned>(std::countr_zero(std::rotr(m_occupied[level], static_cast<int>(start))));
+            best = std::min(best, (base + offset) << shift);
+        }
+        return m_origin + m_resolution * best;
+    }
+
+private:
+    static constexpr unsigned LEVELS{4};
+    static constexpr unsigned SLOT_BITS{6};
+    static constexpr unsigned SLOTS{1u << SLOT_BITS};
+    static constexpr uint64_t SLOT_MASK{SLOTS - 1};
+    static constexpr uint64_t MAX_DELTA{(1ull << (LEVELS * SLOT_BITS)) - 1};
+
+    struct node {
+        uint64_t expires{0};
+        timer_id prev{npos};
+        timer_id next{npos};
+        uint16_t slot{0}; // level * SLOTS + index
+        uint64_t key{0}; // owner handle, e.g. a connection key
+    };
+
+    [[nodiscard]] uint64_t tick_of(clock::time_point t) const noexcept {
+        return t <= m_origin ? 0 : static_cast<uint64_t>((t - m_origin) / m_resolution);
+    }
+
+    [[nodiscard]] uint64_t ceil_tick_of(clock::time_point t) const noexcept {
+        if (t <= m_origin) return 0;
+        const auto elapsed = t - m_origin;
+        const auto ticks = static_cast<uint64_t>(elapsed / m_resolution);
+        return elapsed % m_resolution == clock::duration::zero() ? ticks : ticks + 1;
+    }
+
+    [[nodiscard]] static unsigned slot_of(uint64_t tick, unsigned level) noexcept {
+        return static_cast<unsigned>((tick >> (level * SLOT_BITS)) & SLOT_MASK);
+    }
+
+    timer_id allocate() {
+        if (m_free != npos) {
+            const timer_id id = m_free;
+            m_free = m_nodes[id].next;
+            m_nodes[id] = node{};
+            return id;
+        }
+        m_nodes.emplace_back();
+        return static_cast<timer_id>(m_nodes.size() - 1);
+    }
+
+    void release(timer_id id) noexcept {
+        m_nodes[id].next = m_free;
+        m_free = id;
+    }
+
+    void link(timer_id id) noexcept {
+        node& n = m_nodes[id];
+        uint64_t delta = n.expires - m_next_tick;
+        if (delta > MAX_DELTA) {
+            delta = MAX_DELTA;
+            n.expires = m_next_tick + MAX_DELTA;
+        }
+        unsigned level = 0;
+        while (level + 1 < LEVELS && delta >= (1ull << ((level + 1) * SLOT_BITS))) {
+            ++level;
+        }
+        const unsigned index = slot_of(n.expires, level);
+        const auto slot = static_cast<uint16_t>(level * SLOTS + index);
+
+        n.slot = slot;
+        n.prev = npos;
+        n.next = m_heads[slot];
+        if (n.next != npos) {
+            m_nodes[n.next].prev = id;
+        }
+        m_heads[slot] = id;
+        m_occupied[level] |= 1ull << index;
+    }
+
+    void unlink(timer_id id) noexcept {
+        const node& n = m_nodes[id];
+        if (n.prev != npos) {
+            m_nodes[n.prev].next = n.next;
+        } else {
+            m_heads[n.slot] = n.next;
+        }
+        if (n.next != npos) {
+            m_nodes[n.next].prev = n.prev;
+        }
+        if (m_heads[n.slot] == npos) {
+            m_occupied[n.slot / SLOTS] &= ~(1ull << (n.slot % SLOTS));
+        }
+    }
+
+    // Detaches a whole slot and returns its list head
+    timer_id take_slot(unsigned level, unsigned index) noexcept {
+        const auto slot = level * SLOTS + index;
+        const timer_id head = m_heads[slot];
+        m_heads[slot] = npos;
+        m_occupied[level] &= ~(1ull << index);
+        return head;
+    }
+
+    void cascade(unsigned level, unsigned index) noexcept {
+        for (timer_id id = take_slot(level, index); id != npos;) {
+            const timer_id next = m_nodes[id].next;
+            link(id);
+            id = next;
+        }
+    }
+
+    // Pops one timer at a time so the callback may cancel or schedule others safely
+    template<typename Fn>
+    void expire_slot(unsigned index, Fn& on_expired) {
+        while (m_heads[index] != npos) {
+            const timer_id id = m_heads[index];
+            const uint64_t key = m_nodes[id].key;
+            unlink(id);
+            release(id);
+            --m_count;
+            on_expired(key);
+        }
+    }
+
+    clock::duration m_resolution;
+    clock::time_point m_origin;
+    uint64_t m_next_tick{0}; // first tick not processed yet
+    size_t m_count{0};
+    timer_id m_free{npos};
+    std::vector<node> m_nodes;
+    std::array<timer_id, LEVELS * SLOTS> m_heads{};
+    std::array<uint64_t, LEVELS> m_occupied{};
+};
+
+#endif // TIMING_WHEEL_HPP
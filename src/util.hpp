@@ -203,6 +203,24 @@ inline auto today() {
     return "";
 }
 
+/**
+ * @brief Identifies the process connected to a Unix domain socket, from SO_PEERCRED.
+ * @param sockfd The socket file descriptor.
+ * @return A string like "unix:pid=1234,uid=999", or "unix" if the credentials are unavailable.
+ */
+[[nodiscard]] inline std::string get_peer_credentials(int sockfd) noexcept {
+    try {
+        ucred cred{};
+        socklen_t cred_len = sizeof(cred);
+        if (getsockopt(sockfd, SOL_SOCKET, SO_PEERCRED, &cred, &cred_len) == 0) {
+            return std::format("unix:pid={},uid={}", cred.pid, cred.uid);
+        }
+    } catch (const std::exception& e) {
+        return std::format("get_peer_credentials_exception: {}", e.what());
+    }
+    return "unix";
+}
+
 /**
  * @brief Generates a new version 4 UUID.
  * @return The UUID as a standard formatted string.
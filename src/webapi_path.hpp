@@ -18,6 +18,8 @@ public:
  *
  * This class uses a consteval constructor to ensure that all API paths are
  * checked for correctness at compile time, preventing a class of runtime errors.
+ * The last segment may be a parameter, as in "/download/{name}": the router then matches any
+ * single segment after "/download/" and passes it to the request as the parameter "name".
  */
 struct webapi_path {
 public:
@@ -34,8 +36,20 @@ public:
             throw consteval_error("Invalid WebAPI path: cannot end with '/'");
         }
         
+        std::string_view fixed = path;
+        if (const auto open = path.find('{'); open != std::string_view::npos) {
+            constexpr std::string_view param_chars{"abcdefghijklmnopqrstuvwxyz_"};
+            m_param = path.substr(open + 1, path.size() - open - 2);
+            if (open < 2 || path[open - 1] != '/' || !path.ends_with('}') || m_param.empty()
+                || !std::ranges::all_of(m_param, [&](char c) { return param_chars.contains(c); })) {
+                throw consteval_error("Invalid WebAPI path: a parameter must be the whole last segment, like /file/{name}");
+            }
+            fixed = path.substr(0, open);
+            m_route = fixed;
+        }
+
         constexpr std::string_view valid_chars{"abcdefghijklmnopqrstuvwxyz_-0123456789/"};
-        for(const char c : path) {
+        for(const char c : fixed) {
             if (!valid_chars.contains(c)) {
                 throw consteval_error("Invalid WebAPI path: contains an invalid character");
             }
@@ -52,8 +66,20 @@ public:
         return m_path;
     }
 
+    // The key the router looks up: the whole path, or the part before the parameter, ending in '/'
+    [[nodiscard]] constexpr std::string_view route() const noexcept {
+        return m_param.empty() ? m_path : m_route;
+    }
+
+    // Name of the last segment's parameter; empty for a fixed path
+    [[nodiscard]] constexpr std::string_view param() const noexcept {
+        return m_param;
+    }
+
 private:
     std::string_view m_path;
+    std::string_view m_route{};
+    std::string_view m_param{};
 };
 
 #endif // WEBAPI_PATH_HPP
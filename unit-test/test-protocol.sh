@@ -0,0 +1,156 @@
+#!/bin/bash
+
+# Raw HTTP/1.1 cases that curl cannot produce: pipelined bursts, requests split across packets
+# and malformed request lines. Uses bash's /dev/tcp, so it needs a plain HTTP listener.
+#
+# Usage:
+# ./test-protocol.sh [HOST] [PORT] [URI_PREFIX]
+
+HOST="${1:-${HOST:-localhost}}"
+PORT="${2:-${PORT:-8080}}"
+URI_PREFIX="${3:-${URI_PREFIX:-}}"
+
+# Seconds to wait for responses after the last chunk is sent
+READ_TIMEOUT=2
+
+FAILURES=0
+
+# Sends each argument as a separate write on one connection, pausing between writes so they
+# arrive as separate packets, and prints the status codes of all responses, space separated.
+# Arguments are printf %b strings, so \r\n can be written literally.
+send_raw() {
+    local pause="$1"
+    shift
+    if ! exec 3<>"/dev/tcp/$HOST/$PORT"; then
+        echo "connect-failed"
+        return
+    fi
+    for chunk in "$@"; do
+        printf '%b' "$chunk" >&3
+        sleep "$pause"
+    done
+    timeout "$READ_TIMEOUT" cat <&3 | grep -ao $'^HTTP/1\.1 [0-9]\\{3\\}' | awk '{print $2}' | paste -sd' '
+    exec 3<&-
+}
+
+run_test() {
+    local test_name="$1"
+    local expected="$2"
+    local actual="$3"
+
+    local result_mark="❌ FAIL"
+    if [ "$actual" == "$expected" ]; then
+        result_mark="✅ OK"
+    else
+        ((FAILURES++))
+    fi
+    printf "%-40s | %-16s | %-16s | %-6s\n" "$test_name" "$expected" "${actual:-none}" "$result_mark"
+}
+
+printf "%-40s | %-16s | %-16s | %-6s\n" "Test Case" "Expected" "Actual" "Result"
+printf "%-40s | %-16s | %-16s | %-6s\n" "----------------------------------------" "----------------" "----------------" "------"
+
+PING="GET $URI_PREFIX/ping HTTP/1.1\r\nHost: $HOST\r\n\r\n"
+HELLO="GET $URI_PREFIX/hello HTTP/1.1\r\nHost: $HOST\r\n\r\n"
+
+# --- Pipelining ---
+
+run_test "Pipelined burst, one write" "200 200 200" \
+    "$(send_raw 0 "$PING$HELLO$PING")"
+
+run_test "Pipelined burst, split mid-request" "200 200 200" \
+    "$(send_raw 0.2 "${PING}GET $URI_PREFIX/hel" "lo HTTP/1.1\r\nHost: $HOST\r\n\r\n$PING")"
+
+# A Content-Length that wraps header size + length to zero must be rejected once, not replayed
+post_head="POST $URI_PREFIX/ping HTTP/1.1\r\nHost: $HOST\r\nContent-Type: application/json\r\nContent-Length: "
+head_size=$(( $(printf '%b' "$post_head" | wc -c) + 20 + 4 ))
+wrapping_length=$(printf '%u' $(( -head_size )))
+run_test "Content-Length wrapping to zero" "400" \
+    "$(send_raw 0 "${post_head}${wrapping_length}\r\n\r\n{}$PING")"
+
+run_test "Content-Length above MAX_REQUEST_SIZE" "400" \
+    "$(send_raw 0 "${post_head}99999999999\r\n\r\n{}$PING")"
+
+# A body on a GET would be run as the next request if its length were ignored (CL.0 smuggling)
+printf -v smuggled '%b' "$PING"
+run_test "GET with a body holding a request" "400" \
+    "$(send_raw 0 "GET $URI_PREFIX/ping HTTP/1.1\r\nHost: $HOST\r\nContent-Length: ${#smuggled}\r\n\r\n$PING")"
+
+run_test "GET with Content-Length: 0" "200 200" \
+    "$(send_raw 0 "GET $URI_PREFIX/ping HTTP/1.1\r\nHost: $HOST\r\nContent-Length: 0\r\n\r\n$PING")"
+
+run_test "Pipelined burst, split inside CRLF" "200 200" \
+    "$(send_raw 0.2 "${PING%\\n}" "\n$HELLO")"
+
+# --- Requests split across reads: the parser resumes where the previous read ended ---
+
+printf -v hello_bytes '%b' "$HELLO"
+byte_chunks=()
+for ((i = 0; i < ${#hello_bytes}; i++)); do
+    byte_chunks+=("${hello_bytes:i:1}")
+done
+run_test "Request sent one byte per packet" "200" \
+    "$(send_raw 0.02 "${byte_chunks[@]}")"
+
+run_test "CR and LF in separate packets" "200" \
+    "$(send_raw 0.2 "GET $URI_PREFIX/ping HTTP/1.1\r" "\nHost: $HOST\r" "\n\r" "\n")"
+
+run_test "Header line split mid-name" "200" \
+    "$(send_raw 0.2 "GET $URI_PREFIX/ping HTTP/1.1\r\nHo" "st: $HOST\r\n\r\n")"
+
+# --- Line framing ---
+
+run_test "Bare LF line endings" "400" \
+    "$(send_raw 0 "GET $URI_PREFIX/ping HTTP/1.1\nHost: $HOST\n\n")"
+
+run_test "Bare LF after one header" "400" \
+    "$(send_raw 0 "GET $URI_PREFIX/ping HTTP/1.1\r\nHost: $HOST\n\r\n")"
+
+run_test "Empty lines before the request line" "200" \
+    "$(send_raw 0 "\r\n\r\n$PING")"
+
+run_test "Request line and no headers" "200" \
+    "$(send_raw 0 "GET $URI_PREFIX/ping HTTP/1.1\r\n\r\n")"
+
+# --- Malformed header lines fail as soon as the line ends, without waiting for the blank line ---
+
+run_test "Header without colon, unterminated" "400" \
+    "$(send_raw 0 "GET $URI_PREFIX/ping HTTP/1.1\r\nBad Header\r\n")"
+
+run_test "Invalid header key, unterminated" "400" \
+    "$(send_raw 0 "GET $URI_PREFIX/ping HTTP/1.1\r\nBad Key: x\r\n")"
+
+run_test "Transfer-Encoding" "400" \
+    "$(send_raw 0 "POST $URI_PREFIX/ping HTTP/1.1\r\nHost: $HOST\r\nTransfer-Encoding: chunked\r\n\r\n0\r\n\r\n")"
+
+run_test "Duplicate Host" "400" \
+    "$(send_raw 0 "GET $URI_PREFIX/ping HTTP/1.1\r\nHost: $HOST\r\nHost: other\r\n\r\n")"
+
+run_test "Error after a valid request" "200 400" \
+    "$(send_raw 0 "${PING}GET $URI_PREFIX/ping HTTP/1.1\nHost: $HOST\n\n$PING")"
+
+# --- Header table: names match in any case, and more headers than fit inline still parse ---
+
+run_test "Mixed-case Content-Length framing" "200 200" \
+    "$(send_raw 0 "POST $URI_PREFIX/ping HTTP/1.1\r\nhOST: $HOST\r\ncontent-TYPE: application/json\r\nCONTENT-LENGTH: 2\r\n\r\n{}$PING")"
+
+many_headers=""
+for ((i = 0; i < 40; i++)); do
+    many_headers+="X-Test-$i: $i\r\n"
+done
+run_test "40 headers" "200" \
+    "$(send_raw 0 "GET $URI_PREFIX/ping HTTP/1.1\r\nHost: $HOST\r\n${many_headers}\r\n")"
+
+run_test "More than 50 headers" "400" \
+    "$(send_raw 0 "GET $URI_PREFIX/ping HTTP/1.1\r\nHost: $HOST\r\n${many_headers}${many_headers}\r\n")"
+
+run_test "Duplicate Host in another case" "400" \
+    "$(send_raw 0 "GET $URI_PREFIX/ping HTTP/1.1\r\nHost: $HOST\r\nHOST: other\r\n\r\n")"
+
+echo ""
+if [ "$FAILURES" -eq 0 ]; then
+    echo "✅ All protocol tests passed."
+else
+    echo "❌ $FAILURES protocol test(s) failed."
+fi
+exit "$FAILURES"
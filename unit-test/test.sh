@@ -26,6 +26,18 @@ function show_result {
   [[ "$status" != "200" ]] && echo -e "${body}\n"
 }
 
+# For requests whose expected status is not 200
+function expect_status {
+  local test_name="$1"
+  local expected="$2"
+  local status="$3"
+  local color="$amber"
+  local success="true"
+  if [[ "$status" != "$expected" ]]; then color="$red"; success="false"; fi
+
+  printf "${color}%-35s %-6s %-8s${reset}\n" "$test_name" "$status" "$success"
+}
+
 login_response=$(curl -ks -w "%{http_code}" -H "Content-Type: application/json" \
   -d "$LOGIN_PAYLOAD" "${BASE_URL}${API_PREFIX}/login")
 
@@ -105,4 +117,39 @@ for entry in "${endpoints[@]}"; do
 
   show_result "$method $uri" "$status" "$ok" "$body"
 done
+
+# /download ranges and conditional requests, on a file uploaded for the test
+upload_file=$(mktemp --suffix=.txt)
+printf 'hello range test' > "$upload_file"
+saved_name=$(curl -ks -F "file1=@${upload_file}" -F "title=range test" -H "Authorization: Bearer $TOKEN" \
+  "${BASE_URL}${API_PREFIX}/upload" | jq -r '.savedFilename')
+rm -f "$upload_file"
+
+function download {
+  curl -k -s -o /dev/null -w "%{http_code}" -H "Authorization: Bearer $TOKEN" "${@:2}" "${BASE_URL}${API_PREFIX}/download/$1"
+}
+
+expect_status "GET /download" "200" "$(download "$saved_name")"
+expect_status "GET /download bytes=0-4" "206" "$(download "$saved_name" -H "Range: bytes=0-4")"
+expect_status "GET /download bytes=6-" "206" "$(download "$saved_name" -H "Range: bytes=6-")"
+expect_status "GET /download bytes=-4" "206" "$(download "$saved_name" -H "Range: bytes=-4")"
+expect_status "GET /download past the end" "416" "$(download "$saved_name" -H "Range: bytes=100-")"
+expect_status "GET /download not modified" "304" \
+  "$(download "$saved_name" -H "If-Modified-Since: $(date -u -d '+1 day' '+%a, %d %b %Y %H:%M:%S GMT')")"
+expect_status "GET /download missing file" "404" "$(download "missing-${saved_name}")"
+expect_status "GET /download without a name" "404" "$(download "")"
+
+range_body=$(curl -ks -H "Authorization: Bearer $TOKEN" -H "Range: bytes=0-4" "${BASE_URL}${API_PREFIX}/download/$saved_name")
+expect_status "GET /download bytes=0-4 body" "hello" "$range_body"
+
+# Coroutine handlers: concurrent calls release their workers while SQL runs on the blocking pool, and all complete
+coroutine_ok=$(for i in $(seq 1 16); do
+  curl -k -s -o /dev/null -w "%{http_code}\n" -H "Authorization: Bearer $TOKEN" "${BASE_URL}${API_PREFIX}/shippers" &
+done | grep -c '^200$')
+expect_status "GET /shippers x16 concurrent" "16" "$coroutine_ok"
+
+# Readiness: an idle server reports READY with a weight for the load balancer
+ready_response=$(curl -k -s -w "%{http_code}" "${BASE_URL}${API_PREFIX}/ready")
+expect_status "GET /ready" "200" "${ready_response: -3}"
+expect_status "GET /ready status" "READY" "$(echo "${ready_response::-3}" | jq -r '.status')"
 exit 0